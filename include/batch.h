@@ -0,0 +1,168 @@
+#pragma once
+#include "mesh.h"
+#include <vector>
+
+namespace illusion {
+
+	//о̬干ͬһ׻壬ϴʱԤȱ任ռ䣬
+	//ͬһʵÿpassֻҪһglMultiDrawElements
+	class Batch {
+		//(diffuse, specular)ֵĻ
+		struct Group {
+			Texture* diffuse, * specular;
+			std::vector<GLsizei> counts; //glMultiDrawElementsĲ
+			std::vector<const void*> offsets;
+			std::vector<GLsizei> visible_counts; //޳Ĳÿ֡
+			std::vector<const void*> visible_offsets;
+		};
+		//ڹеλ
+		struct Item {
+			unsigned group;
+			unsigned first_vertex, vertex_num;
+			unsigned first_index, index_num;
+			glm::mat4 model;
+			AABB local_bound; //ģͿռİΧ
+		};
+
+		std::vector<Vertex> local; //ֲռ䶥㣬ƶʱ±任
+		std::vector<Vertex> vertices; //ռ䶥
+		std::vector<unsigned> indices; //Ѿʼ
+		std::vector<Item> items;
+		std::vector<Group> groups;
+		unsigned VAO, VBO, EBO;
+
+		Batch(const Batch&) = delete;
+
+		//Ķ任ռ
+		void transform(const Item& item) {
+			glm::mat3 normal_matrix = glm::transpose(glm::inverse(glm::mat3(item.model)));
+			for (unsigned i = item.first_vertex; i < item.first_vertex + item.vertex_num; ++i) {
+				vertices[i].position = glm::vec3(item.model * glm::vec4(local[i].position, 1.0f));
+				vertices[i].normal = normal_matrix * local[i].normal;
+				vertices[i].coord = local[i].coord;
+			}
+		}
+
+	public:
+		Batch() :VAO(~0), VBO(~0), EBO(~0) {}
+		~Batch() {
+			if (~VAO) {
+				glDeleteVertexArrays(1, &VAO);
+				glDeleteBuffers(1, &VBO);
+				glDeleteBuffers(1, &EBO);
+			}
+		}
+
+		unsigned size() const { return items.size(); }
+
+		//һ壬
+		unsigned add(const std::vector<Vertex>& vert, const std::vector<unsigned>& ind,
+					 Texture* diffuse, Texture* specular, const glm::mat4& model) {
+			unsigned g = 0;
+			while (g < groups.size() && (groups[g].diffuse != diffuse || groups[g].specular != specular)) ++g;
+			if (g == groups.size()) {
+				groups.emplace_back();
+				groups[g].diffuse = diffuse;
+				groups[g].specular = specular;
+			}
+
+			Item item{ g, (unsigned)local.size(), (unsigned)vert.size(), (unsigned)indices.size(), (unsigned)ind.size(), model,
+					   Mesh::calc_bound(vert, glm::mat4(1.0f)) };
+			local.insert(local.end(), vert.begin(), vert.end());
+			vertices.resize(local.size());
+			for (unsigned i : ind) indices.push_back(i + item.first_vertex);
+			transform(item);
+
+			groups[g].counts.push_back(item.index_num);
+			groups[g].offsets.push_back((const void*)(item.first_index * sizeof(unsigned)));
+			items.push_back(item);
+			return items.size() - 1;
+		}
+
+		//޸ı任ֻϴĶ
+		void set_model(unsigned id, const glm::mat4& model) {
+			Item& item = items[id];
+			item.model = model;
+			transform(item);
+			if (~VBO) {
+				glBindBuffer(GL_ARRAY_BUFFER, VBO);
+				glBufferSubData(GL_ARRAY_BUFFER, item.first_vertex * sizeof(Vertex),
+								item.vertex_num * sizeof(Vertex), vertices.data() + item.first_vertex);
+			}
+		}
+
+		//ռİΧ
+		AABB get_bound(unsigned id) const { return items[id].local_bound.transform(items[id].model); }
+
+		//һ
+		void draw_one(Program& prog, unsigned id) {
+			if (!~VAO) return;
+			const Item& item = items[id];
+			const Group& g = groups[item.group];
+			prog.set("model", glm::mat4(1.0f));
+			if (g.diffuse) g.diffuse->bind(0), prog.set("material.diffuse", 0);
+			if (g.specular) g.specular->bind(1), prog.set("material.specular", 1);
+			glBindVertexArray(VAO);
+			glDrawElements(GL_TRIANGLES, item.index_num, GL_UNSIGNED_INT, (const void*)(item.first_index * sizeof(unsigned)));
+			glBindVertexArray(0);
+		}
+
+		//ѺϲϴGPU
+		void upload() {
+			if (indices.empty()) return;
+			if (!~VAO) {
+				glGenVertexArrays(1, &VAO);
+				glGenBuffers(1, &VBO);
+				glGenBuffers(1, &EBO);
+			}
+			glBindVertexArray(VAO);
+			glBindBuffer(GL_ARRAY_BUFFER, VBO);
+			glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_DYNAMIC_DRAW);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned), indices.data(), GL_STATIC_DRAW);
+
+			glEnableVertexAttribArray(0);
+			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+			glEnableVertexAttribArray(1);
+			glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+			glEnableVertexAttribArray(2);
+			glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, coord));
+			glBindVertexArray(0);
+		}
+
+		//壬ÿһε
+		void draw(Program& prog) {
+			if (!~VAO) return;
+			prog.set("model", glm::mat4(1.0f));
+			glBindVertexArray(VAO);
+			for (auto& g : groups) {
+				if (g.diffuse) g.diffuse->bind(0), prog.set("material.diffuse", 0);
+				if (g.specular) g.specular->bind(1), prog.set("material.specular", 1);
+				glMultiDrawElements(GL_TRIANGLES, g.counts.data(), GL_UNSIGNED_INT, g.offsets.data(), g.counts.size());
+			}
+			glBindVertexArray(0);
+		}
+
+		//ֻidsе
+		void draw(Program& prog, const std::vector<unsigned>& ids) {
+			if (!~VAO) return;
+			for (auto& g : groups) g.visible_counts.clear(), g.visible_offsets.clear();
+			for (unsigned id : ids) {
+				Group& g = groups[items[id].group];
+				g.visible_counts.push_back(items[id].index_num);
+				g.visible_offsets.push_back((const void*)(items[id].first_index * sizeof(unsigned)));
+			}
+			prog.set("model", glm::mat4(1.0f));
+			glBindVertexArray(VAO);
+			for (auto& g : groups) {
+				if (g.visible_counts.empty()) continue;
+				if (g.diffuse) g.diffuse->bind(0), prog.set("material.diffuse", 0);
+				if (g.specular) g.specular->bind(1), prog.set("material.specular", 1);
+				glMultiDrawElements(GL_TRIANGLES, g.visible_counts.data(), GL_UNSIGNED_INT,
+									g.visible_offsets.data(), g.visible_counts.size());
+			}
+			glBindVertexArray(0);
+		}
+	};
+
+}
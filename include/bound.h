@@ -0,0 +1,170 @@
+#pragma once
+#include "basic.h"
+#include <vector>
+#include <cfloat>
+#include <cmath>
+
+namespace illusion {
+
+	//Χ
+	struct AABB {
+		glm::vec3 min, max;
+
+		AABB() :min(glm::vec3(FLT_MAX)), max(glm::vec3(-FLT_MAX)) {}
+		AABB(const glm::vec3& min, const glm::vec3& max) :min(min), max(max) {}
+
+		bool empty() const { return min.x > max.x; }
+		glm::vec3 center() const { return (min + max) * 0.5f; }
+		glm::vec3 extent() const { return (max - min) * 0.5f; }
+		float radius() const { return glm::length(max - min) * 0.5f; }
+
+		//SAH
+		float area() const {
+			if (empty()) return 0.0f;
+			glm::vec3 d = max - min;
+			return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+		}
+
+		void extend(const glm::vec3& p) { min = glm::min(min, p); max = glm::max(max, p); }
+		void extend(const AABB& rhs) { min = glm::min(min, rhs.min); max = glm::max(max, rhs.max); }
+
+		//任İΧУȻģ
+		AABB transform(const glm::mat4& m) const {
+			if (empty()) return *this;
+			glm::vec3 c = glm::vec3(m * glm::vec4(center(), 1.0f));
+			glm::mat3 a = glm::mat3(m);
+			for (int i = 0; i < 3; ++i) a[i] = glm::abs(a[i]);
+			glm::vec3 e = a * extent();
+			return AABB(c - e, c + e);
+		}
+	};
+
+	//׶壬ƽķָ׶ڲ
+	struct Frustum {
+		glm::vec4 planes[6];
+
+		Frustum() {}
+		//ͶӰ*۲ȡ6ƽ
+		Frustum(const glm::mat4& m) {
+			glm::mat4 t = glm::transpose(m);
+			planes[0] = t[3] + t[0];
+			planes[1] = t[3] - t[0];
+			planes[2] = t[3] + t[1];
+			planes[3] = t[3] - t[1];
+			planes[4] = t[3] + t[2];
+			planes[5] = t[3] - t[2];
+			for (auto& p : planes) p /= glm::length(glm::vec3(p));
+		}
+
+		bool intersect(const AABB& box) const {
+			glm::vec3 c = box.center(), e = box.extent();
+			for (auto& p : planes) {
+				glm::vec3 n = glm::vec3(p);
+				if (glm::dot(n, c) + p.w + glm::dot(glm::abs(n), e) < 0.0f) return false;
+			}
+			return true;
+		}
+
+		//ΧǷȫ׶ڲ
+		bool contain(const AABB& box) const {
+			glm::vec3 c = box.center(), e = box.extent();
+			for (auto& p : planes) {
+				glm::vec3 n = glm::vec3(p);
+				if (glm::dot(n, c) + p.w - glm::dot(glm::abs(n), e) < 0.0f) return false;
+			}
+			return true;
+		}
+	};
+
+	//SoAʽŵİΧУ޳
+	class BoundSet {
+		static constexpr unsigned lane = 8; //鳤ȰAVXȶ
+		std::vector<float> cx, cy, cz; //Χ
+		std::vector<float> ex, ey, ez; //Χа볤
+		unsigned num;
+
+		//Դfirstʼ4ΧУؿɼ
+		int test4(const Frustum& f, unsigned first) const {
+			__m128 x = _mm_loadu_ps(&cx[first]), y = _mm_loadu_ps(&cy[first]), z = _mm_loadu_ps(&cz[first]);
+			__m128 a = _mm_loadu_ps(&ex[first]), b = _mm_loadu_ps(&ey[first]), c = _mm_loadu_ps(&ez[first]);
+			__m128 inside = _mm_cmpeq_ps(_mm_setzero_ps(), _mm_setzero_ps());
+			for (auto& p : f.planes) {
+				__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(p.x)), _mm_mul_ps(y, _mm_set1_ps(p.y))),
+									  _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(p.z)), _mm_set1_ps(p.w)));
+				__m128 s = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, _mm_set1_ps(std::fabs(p.x))), _mm_mul_ps(b, _mm_set1_ps(std::fabs(p.y)))),
+									  _mm_mul_ps(c, _mm_set1_ps(std::fabs(p.z))));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(d, s), _mm_setzero_ps()));
+			}
+			return _mm_movemask_ps(inside);
+		}
+
+#ifdef __AVX__
+		//Դfirstʼ8ΧУؿɼ
+		int test8(const Frustum& f, unsigned first) const {
+			__m256 x = _mm256_loadu_ps(&cx[first]), y = _mm256_loadu_ps(&cy[first]), z = _mm256_loadu_ps(&cz[first]);
+			__m256 a = _mm256_loadu_ps(&ex[first]), b = _mm256_loadu_ps(&ey[first]), c = _mm256_loadu_ps(&ez[first]);
+			__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (auto& p : f.planes) {
+				__m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(p.x)), _mm256_mul_ps(y, _mm256_set1_ps(p.y))),
+										 _mm256_add_ps(_mm256_mul_ps(z, _mm256_set1_ps(p.z)), _mm256_set1_ps(p.w)));
+				__m256 s = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a, _mm256_set1_ps(std::fabs(p.x))), _mm256_mul_ps(b, _mm256_set1_ps(std::fabs(p.y)))),
+										 _mm256_mul_ps(c, _mm256_set1_ps(std::fabs(p.z))));
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(d, s), _mm256_setzero_ps(), _CMP_GE_OQ));
+			}
+			return _mm256_movemask_ps(inside);
+		}
+#endif
+
+		//firstʼlaneλУЧ䣩λõ
+		int valid_mask(unsigned first) const {
+			return num - first >= lane ? (1 << lane) - 1 : (1 << (num - first)) - 1;
+		}
+
+		//λ1λ
+		static unsigned bit_index(int mask) {
+			unsigned ret = 0;
+			while (!(mask & 1)) mask >>= 1, ++ret;
+			return ret;
+		}
+
+	public:
+		BoundSet() :num(0) {}
+
+		unsigned size() const { return num; }
+
+		//һΧУ
+		unsigned add(const AABB& box) {
+			if (num % lane == 0)
+				for (auto* v : { &cx, &cy, &cz, &ex, &ey, &ez }) v->resize(num + lane, 0.0f);
+			set(num, box);
+			return num++;
+		}
+
+		void set(unsigned id, const AABB& box) {
+			glm::vec3 c = box.center(), e = box.extent();
+			cx[id] = c.x, cy[id] = c.y, cz[id] = c.z;
+			ex[id] = e.x, ey[id] = e.y, ez[id] = e.z;
+		}
+
+		AABB get(unsigned id) const {
+			glm::vec3 c(cx[id], cy[id], cz[id]), e(ex[id], ey[id], ez[id]);
+			return AABB(c - e, c + e);
+		}
+
+		//׶޳ɼı׷ӵvisibleУؿɼ
+		unsigned cull(const Frustum& f, std::vector<unsigned>& visible) const {
+			unsigned count = 0;
+			for (unsigned i = 0; i < num; i += lane) {
+#ifdef __AVX__
+				int mask = test8(f, i);
+#else
+				int mask = test4(f, i) | (test4(f, i + 4) << 4);
+#endif
+				mask &= valid_mask(i);
+				for (; mask; mask &= mask - 1, ++count) visible.push_back(i + bit_index(mask));
+			}
+			return count;
+		}
+	};
+
+}
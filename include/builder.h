@@ -9,8 +9,9 @@ namespace illusion {
 		std::vector<unsigned> indices; //
 		const char* diffuse, * specular; //·
 		glm::mat4 model; //任
-		BasicBuilder(const char* diffuse, const char* specular)
-			:diffuse(diffuse), specular(specular), model(glm::mat4(1.0f)) {}
+		bool occluder; //ǷΪڵ޳ڵ
+		BasicBuilder(const char* diffuse, const char* specular, bool occluder = false)
+			:diffuse(diffuse), specular(specular), model(glm::mat4(1.0f)), occluder(occluder) {}
 		virtual void build() = 0;
 		void rotate(int degree, const glm::vec3& axis) {
 			model = glm::rotate(model, degree * glm::pi<float>() / 180.0f, axis);
@@ -25,10 +26,10 @@ namespace illusion {
 
 	//ƽbuilder
 	struct PlaneBuilder : public BasicBuilder {
-		PlaneBuilder(const glm::vec3& center, float size, const char* diffuse = nullptr) :BasicBuilder(diffuse, diffuse) {
+		PlaneBuilder(const glm::vec3& center, float size, const char* diffuse = nullptr) :BasicBuilder(diffuse, diffuse, true) {
 			model = glm::translate(glm::scale(model, glm::vec3(size)), center / size);
 		}
-		PlaneBuilder(const glm::vec3& center, float size, const char* diffuse, const char* specular) :BasicBuilder(diffuse, specular) {
+		PlaneBuilder(const glm::vec3& center, float size, const char* diffuse, const char* specular) :BasicBuilder(diffuse, specular, true) {
 			model = glm::translate(glm::scale(model, glm::vec3(size)), center / size);
 		}
 
@@ -47,10 +48,10 @@ namespace illusion {
 
 	//builder
 	struct CubeBuilder : public BasicBuilder {
-		CubeBuilder(const glm::vec3& pos, float size, const char* diffuse = nullptr) :BasicBuilder(diffuse, diffuse) {
+		CubeBuilder(const glm::vec3& pos, float size, const char* diffuse = nullptr) :BasicBuilder(diffuse, diffuse, true) {
 			model = glm::translate(glm::scale(model, glm::vec3(size)), pos / size);
 		}
-		CubeBuilder(const glm::vec3& pos, float size, const char* diffuse, const char* specular) : BasicBuilder(diffuse, specular) {
+		CubeBuilder(const glm::vec3& pos, float size, const char* diffuse, const char* specular) : BasicBuilder(diffuse, specular, true) {
 			model = glm::translate(glm::scale(model, glm::vec3(size)), pos / size);
 		}
 
@@ -108,10 +109,10 @@ namespace illusion {
 	};
 
 	struct RoomBuilder : public BasicBuilder {
-		RoomBuilder(const glm::vec3& pos, float size, const char* diffuse = nullptr) :BasicBuilder(diffuse, diffuse) {
+		RoomBuilder(const glm::vec3& pos, float size, const char* diffuse = nullptr) :BasicBuilder(diffuse, diffuse, true) {
 			model = glm::translate(glm::scale(model, glm::vec3(size)), pos / size);
 		}
-		RoomBuilder(const glm::vec3& pos, float size, const char* diffuse, const char* specular) : BasicBuilder(diffuse, specular) {
+		RoomBuilder(const glm::vec3& pos, float size, const char* diffuse, const char* specular) : BasicBuilder(diffuse, specular, true) {
 			model = glm::translate(glm::scale(model, glm::vec3(size)), pos / size);
 		}
 
@@ -168,5 +169,32 @@ namespace illusion {
 		}
 	};
 
+	//builderγ߻
+	struct SphereBuilder : public BasicBuilder {
+		unsigned slices, stacks; //ߺγ߷ķֶ
+		SphereBuilder(const glm::vec3& pos, float radius, unsigned slices = 16, unsigned stacks = 8, const char* diffuse = nullptr)
+			:BasicBuilder(diffuse, diffuse), slices(slices), stacks(stacks) {
+			model = glm::translate(glm::scale(model, glm::vec3(radius)), pos / radius);
+		}
+
+		void build() {
+			vertices.clear();
+			indices.clear();
+			for (unsigned i = 0; i <= stacks; ++i) {
+				float theta = glm::pi<float>() * i / stacks;
+				for (unsigned j = 0; j <= slices; ++j) {
+					float phi = 2.0f * glm::pi<float>() * j / slices;
+					glm::vec3 p(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+					vertices.push_back(Vertex{ p, p, glm::vec2(float(j) / slices, 1.0f - float(i) / stacks) });
+				}
+			}
+			for (unsigned i = 0; i < stacks; ++i) {
+				for (unsigned j = 0; j < slices; ++j) {
+					unsigned a = i * (slices + 1) + j, b = a + slices + 1;
+					indices.insert(indices.end(), { a, a + 1, b, a + 1, b + 1, b });
+				}
+			}
+		}
+	};
 	
 }
\ No newline at end of file
@@ -0,0 +1,161 @@
+#pragma once
+#include "bound.h"
+#include <vector>
+
+namespace illusion {
+
+	//ĲΰΧУSAHƶʱֻԵϸ°Χ
+	class BVH {
+		static constexpr unsigned bin_num = 12; //SAHʱÿͰ
+		static constexpr unsigned max_leaf = 4; //Ҷӽڵ
+
+		struct Node {
+			AABB box;
+			unsigned first, count; //primsе
+			unsigned left; //ӱţҺΪleft + 1ҶӽڵΪ0
+			unsigned parent;
+		};
+
+		std::vector<Node> nodes;
+		std::vector<unsigned> prims; //ڵ˳е
+		std::vector<unsigned> leaf_of; //ڵҶӽڵ
+		std::vector<AABB> boxes; //ÿİΧ
+		mutable std::vector<unsigned> stack; //õջ
+
+		void update(unsigned id) {
+			Node& node = nodes[id];
+			node.box = AABB();
+			if (node.left) {
+				node.box.extend(nodes[node.left].box);
+				node.box.extend(nodes[node.left + 1].box);
+			} else for (unsigned i = node.first; i < node.first + node.count; ++i) node.box.extend(boxes[prims[i]]);
+		}
+
+		void subdivide(unsigned id) {
+			update(id);
+			unsigned first = nodes[id].first, count = nodes[id].count;
+			if (count <= 1) return;
+
+			AABB centroid;
+			for (unsigned i = first; i < first + count; ++i) centroid.extend(boxes[prims[i]].center());
+
+			//ÿϷͰѰҴСĻ
+			float best_cost = FLT_MAX;
+			int best_axis = -1;
+			unsigned best_split = 0;
+			for (int axis = 0; axis < 3; ++axis) {
+				float lo = centroid.min[axis], hi = centroid.max[axis];
+				if (hi <= lo) continue;
+				AABB bin_box[bin_num];
+				unsigned bin_count[bin_num] = {};
+				for (unsigned i = first; i < first + count; ++i) {
+					unsigned b = bin_of(boxes[prims[i]].center()[axis], lo, hi);
+					bin_box[b].extend(boxes[prims[i]]);
+					++bin_count[b];
+				}
+				float left_area[bin_num - 1];
+				unsigned left_count[bin_num - 1];
+				AABB acc;
+				unsigned n = 0;
+				for (unsigned b = 0; b < bin_num - 1; ++b) {
+					acc.extend(bin_box[b]);
+					n += bin_count[b];
+					left_area[b] = acc.area();
+					left_count[b] = n;
+				}
+				acc = AABB();
+				n = 0;
+				for (unsigned b = bin_num - 1; b > 0; --b) {
+					acc.extend(bin_box[b]);
+					n += bin_count[b];
+					float cost = left_area[b - 1] * left_count[b - 1] + acc.area() * n;
+					if (left_count[b - 1] && n && cost < best_cost) {
+						best_cost = cost;
+						best_axis = axis;
+						best_split = b;
+					}
+				}
+			}
+
+			float leaf_cost = nodes[id].box.area() * count;
+			if (best_axis < 0 || (best_cost >= leaf_cost && count <= max_leaf)) return;
+
+			//
+			float lo = centroid.min[best_axis], hi = centroid.max[best_axis];
+			unsigned i = first, j = first + count;
+			while (i < j) {
+				if (bin_of(boxes[prims[i]].center()[best_axis], lo, hi) < best_split) ++i;
+				else std::swap(prims[i], prims[--j]);
+			}
+
+			unsigned left = nodes.size();
+			nodes.push_back(Node{ AABB(), first, i - first, 0, id });
+			nodes.push_back(Node{ AABB(), i, first + count - i, 0, id });
+			nodes[id].left = left;
+			subdivide(left);
+			subdivide(left + 1);
+		}
+
+		static unsigned bin_of(float c, float lo, float hi) {
+			unsigned b = (unsigned)((c - lo) / (hi - lo) * bin_num);
+			return b < bin_num ? b : bin_num - 1;
+		}
+
+	public:
+		BVH() {}
+
+		bool empty() const { return nodes.empty(); }
+
+		//İΧ¹
+		void build(const BoundSet& bounds) {
+			unsigned n = bounds.size();
+			boxes.resize(n);
+			prims.resize(n);
+			leaf_of.resize(n);
+			for (unsigned i = 0; i < n; ++i) boxes[i] = bounds.get(i), prims[i] = i;
+			nodes.clear();
+			if (!n) return;
+			nodes.reserve(2 * n);
+			nodes.push_back(Node{ AABB(), 0, n, 0, 0 });
+			subdivide(0);
+			for (unsigned i = 0; i < nodes.size(); ++i)
+				if (!nodes[i].left)
+					for (unsigned j = nodes[i].first; j < nodes[i].first + nodes[i].count; ++j) leaf_of[prims[j]] = i;
+		}
+
+		//İΧиıҶӵ·
+		void refit(unsigned id, const AABB& box) {
+			boxes[id] = box;
+			unsigned node = leaf_of[id];
+			while (true) {
+				update(node);
+				if (!node) break;
+				node = nodes[node].parent;
+			}
+		}
+
+		//ѯTཻ壬TҪṩintersectcontain׷ӵoutУظ
+		template<typename T>
+		unsigned query(const T& volume, std::vector<unsigned>& out) const {
+			if (nodes.empty()) return 0;
+			unsigned count = 0;
+			stack.assign(1, 0);
+			while (!stack.empty()) {
+				const Node& node = nodes[stack.back()];
+				stack.pop_back();
+				if (!volume.intersect(node.box)) continue;
+				if (!node.left || volume.contain(node.box)) {
+					//Ҷӽڵԣȫڲֱȫ
+					bool inside = node.left != 0;
+					for (unsigned i = node.first; i < node.first + node.count; ++i)
+						if (inside || volume.intersect(boxes[prims[i]])) out.push_back(prims[i]), ++count;
+				} else {
+					stack.push_back(node.left + 1);
+					stack.push_back(node.left);
+				}
+			}
+			return count;
+		}
+	};
+
+}
@@ -0,0 +1,151 @@
+#pragma once
+#include "shader.h"
+#include "light.h"
+#include "bound.h"
+#include <vector>
+
+namespace illusion {
+
+	//ƽйļӰ׶尴ȻΪɶΣÿһͶӰǣ
+	//м2DУüɫһλƵ
+	class CascadedShadow {
+	public:
+		static constexpr int max_cascade_num = 4; //ҪɫеMAX_CASCADE_NUMһ
+		static constexpr int size = 1024; //ÿķֱ
+
+	private:
+		static constexpr int unit = 13; //󶨵Ԫ
+		static constexpr float split_lambda = 0.75f; //ȻֵĻϱ
+		static constexpr float caster_distance = 50.0f; //Χ֮⡢ԴԻͶӰľ
+
+		Program prog;
+		unsigned tex, FBO;
+		int cascade_num;
+		bool enabled; //Ƿƽй
+		glm::vec3 light_dir;
+		glm::mat4 light_view; //̶ԭĹԴ۲󣬱ֻ֤ƽƶת
+		float splits[max_cascade_num + 1]; //ÿڹ۲ռȷΧ
+		float radius[max_cascade_num]; //ÿΧİ뾶޹
+		glm::mat4 matrices[max_cascade_num]; //ÿͶӰ*۲
+		float tan_x, tan_y;
+
+		//۲ռ[d0, d1]׶8ǵ
+		void corners(float d0, float d1, glm::vec3* out) const {
+			int k = 0;
+			for (float d : { d0, d1 })
+				for (int sx = -1; sx <= 1; sx += 2)
+					for (int sy = -1; sy <= 1; sy += 2)
+						out[k++] = glm::vec3(sx * tan_x * d, sy * tan_y * d, -d);
+		}
+
+	public:
+		CascadedShadow() :tex(~0), FBO(~0), cascade_num(max_cascade_num), enabled(false), light_dir(0.0f, -1.0f, 0.0f),
+			light_view(1.0f), splits{}, radius{}, tan_x(1.0f), tan_y(1.0f) {}
+		CascadedShadow(const CascadedShadow&) = delete;
+		~CascadedShadow() {
+			if (~FBO) glDeleteFramebuffers(1, &FBO);
+			if (~tex) glDeleteTextures(1, &tex);
+		}
+
+		//numΪ2~4shadow_distanceΪӰԶ
+		bool init(const Program& target, const glm::mat4& projection, float near_plane, float shadow_distance, int num = max_cascade_num) {
+			Shader vs(GL_VERTEX_SHADER, "./shader/cascade.vs");
+			Shader gs(GL_GEOMETRY_SHADER, "./shader/cascade.gs");
+			Shader fs(GL_FRAGMENT_SHADER, "./shader/bound.fs");
+			if (vs.fail() || gs.fail() || fs.fail() || !prog.link(vs, fs, gs)) return false;
+			cascade_num = std::min(std::max(num, 2), max_cascade_num);
+			tan_x = 1.0f / projection[0][0];
+			tan_y = 1.0f / projection[1][1];
+
+			//ֺ;Ȼְ
+			for (int i = 0; i <= cascade_num; ++i) {
+				float t = float(i) / cascade_num;
+				float log_split = near_plane * std::pow(shadow_distance / near_plane, t);
+				float uniform_split = near_plane + (shadow_distance - near_plane) * t;
+				splits[i] = split_lambda * log_split + (1.0f - split_lambda) * uniform_split;
+			}
+			//Χİ뾶ֻ׶״йأȡĴСֲ
+			for (int i = 0; i < cascade_num; ++i) {
+				glm::vec3 p[8], center(0.0f);
+				corners(splits[i], splits[i + 1], p);
+				for (auto& v : p) center += v / 8.0f;
+				float r = 0.0f;
+				for (auto& v : p) r = std::max(r, glm::length(v - center));
+				radius[i] = std::ceil(r * 16.0f) / 16.0f;
+			}
+
+			glGenTextures(1, &tex);
+			glActiveTexture(GL_TEXTURE15);
+			glBindTexture(GL_TEXTURE_2D_ARRAY, tex);
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, size, size, max_cascade_num, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glGenFramebuffers(1, &FBO);
+			glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+			glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, tex, 0);
+			glDrawBuffer(GL_NONE);
+			glReadBuffer(GL_NONE);
+			if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+				std::cerr << "ERROR::FRAMEBUFFER::CASCADE_INCOMPLETE" << std::endl;
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+			prog.set("cascade_num", cascade_num);
+			target.set("cascade_map", unit);
+			target.set("cascade_num", 0);
+			for (int i = 0; i < cascade_num; ++i) {
+				std::string name = "cascade_splits[" + std::to_string(i) + "]";
+				target.set(name.c_str(), splits[i + 1]);
+			}
+			return true;
+		}
+
+		void set_light(const Program& target, const DirLight& light) {
+			light_dir = glm::normalize(light.dir);
+			glm::vec3 up = std::abs(light_dir.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+			light_view = glm::lookAt(glm::vec3(0.0f), light_dir, up);
+			enabled = true;
+			target.set("cascade_num", cascade_num);
+		}
+
+		bool has_light() const { return enabled; }
+		int get_cascade_num() const { return cascade_num; }
+		const glm::mat4* get_matrices() const { return matrices; }
+
+		//ÿƣdraw(prog, matrices, num)һཻ岢
+		template<typename F>
+		unsigned update(const Program& target, const glm::mat4& view, F&& draw) {
+			if (!enabled) return 0;
+			glm::mat4 inv_view = glm::inverse(view);
+			float texel_scale = size * 0.5f;
+			for (int i = 0; i < cascade_num; ++i) {
+				glm::vec3 p[8], center(0.0f);
+				corners(splits[i], splits[i + 1], p);
+				for (auto& v : p) center += v / 8.0f;
+				glm::vec3 c = glm::vec3(light_view * inv_view * glm::vec4(center, 1.0f));
+				//ΧڹԴռж뵽texelƶʱӰԵ˸
+				float r = radius[i], texel = r / texel_scale;
+				c.x = std::floor(c.x / texel) * texel;
+				c.y = std::floor(c.y / texel) * texel;
+				glm::mat4 ortho = glm::ortho(c.x - r, c.x + r, c.y - r, c.y + r, -c.z - r - caster_distance, -c.z + r);
+				matrices[i] = ortho * light_view;
+				std::string name = "cascade_matrices[" + std::to_string(i) + "]";
+				prog.set(name.c_str(), matrices[i]);
+				target.set(name.c_str(), matrices[i]);
+			}
+
+			glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+			glViewport(0, 0, size, size);
+			glClear(GL_DEPTH_BUFFER_BIT);
+			unsigned num = draw(prog, matrices, cascade_num);
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			glActiveTexture(GL_TEXTURE0 + unit);
+			glBindTexture(GL_TEXTURE_2D_ARRAY, tex);
+			return num;
+		}
+	};
+
+}
@@ -0,0 +1,201 @@
+#pragma once
+#include "shader.h"
+#include "texture.h"
+#include "light.h"
+#include <vector>
+#include <cstdint>
+
+namespace illusion {
+
+	//ִǰȾѹ۲ռ׶廮Ϊgrid_x * grid_y * grid_zأȷָ֣
+	//ÿ֡CPUϰѹԴ䵽Ӱ췶ΧཻĴУɫֻƬڴصĹԴ
+	class Clustered {
+	public:
+		static constexpr int grid_x = 16, grid_y = 9, grid_z = 24; //Ҫobject_clustered.fsеgrid_sizeһ
+		static constexpr unsigned max_light_num = 65535; //Դ16λ
+
+	private:
+		static constexpr int cluster_num = grid_x * grid_y * grid_z;
+		static constexpr int light_stride = 5; //ÿԴlight_bufռõtexel
+		static constexpr int unit = 5; //󶨵ʼԪ
+
+		float z_near, z_scale; //ȷslice = log(depth / z_near) * z_scale
+		//ÿڹ۲ռİΧУSoA֣ͬһеĴţһβ4
+		std::vector<float> min_x, min_y, min_z, max_x, max_y, max_z;
+
+		std::vector<PointLight> point_lights;
+		std::vector<SpotLight> spot_lights;
+		std::vector<float> ranges; //ԴӰ뾶
+		bool lights_dirty; //ԴҪϴ
+
+		std::vector<unsigned> counts; //ÿصĹԴ
+		std::vector<unsigned> pair_cluster, pair_light; //֡õ(, Դ)
+		std::vector<unsigned> cluster_data; //ÿlight_indexеʼλú͹Դ
+		std::vector<uint16_t> light_index;
+		TextureBuffer cluster_buf, index_buf, light_buf;
+
+		int slice_of(float depth) const {
+			int z = (int)std::floor(std::log(std::max(depth, z_near) / z_near) * z_scale);
+			return std::min(std::max(z, 0), grid_z - 1);
+		}
+
+		void add_pair(unsigned cluster, unsigned light) {
+			pair_cluster.push_back(cluster);
+			pair_light.push_back(light);
+			++counts[cluster];
+		}
+
+		//صİΧ󽻣ÿβһе4
+		void bin_sphere(unsigned light, const glm::vec3& p, float r) {
+			float depth = -p.z;
+			if (depth + r < z_near || depth - r > z_near * std::exp(grid_z / z_scale)) return;
+			int z0 = slice_of(depth - r), z1 = slice_of(depth + r);
+			__m128 px = _mm_set1_ps(p.x), py = _mm_set1_ps(p.y), pz = _mm_set1_ps(p.z);
+			__m128 r2 = _mm_set1_ps(r * r), zero = _mm_setzero_ps();
+			for (int z = z0; z <= z1; ++z) {
+				for (int y = 0; y < grid_y; ++y) {
+					for (int x = 0; x < grid_x; x += 4) {
+						unsigned base = (z * grid_y + y) * grid_x + x;
+						__m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&min_x[base]), px), _mm_sub_ps(px, _mm_loadu_ps(&max_x[base]))), zero);
+						__m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&min_y[base]), py), _mm_sub_ps(py, _mm_loadu_ps(&max_y[base]))), zero);
+						__m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&min_z[base]), pz), _mm_sub_ps(pz, _mm_loadu_ps(&max_z[base]))), zero);
+						__m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+						int mask = _mm_movemask_ps(_mm_cmple_ps(d2, r2));
+						for (int i = 0; i < 4; ++i) if (mask >> i & 1) add_pair(base + i, light);
+					}
+				}
+			}
+		}
+
+		//Բ׶صİΧ󽻣۹û˥Բ׶ĳȲ
+		void bin_cone(unsigned light, const glm::vec3& p, const glm::vec3& dir, float cos_angle) {
+			float sin_angle = std::sqrt(std::max(0.0f, 1.0f - cos_angle * cos_angle));
+			for (unsigned i = 0; i < (unsigned)cluster_num; ++i) {
+				glm::vec3 lo(min_x[i], min_y[i], min_z[i]), hi(max_x[i], max_y[i], max_z[i]);
+				glm::vec3 center = (lo + hi) * 0.5f;
+				float radius = glm::length(hi - center);
+				glm::vec3 v = center - p;
+				float along = glm::dot(v, dir);
+				float dist = cos_angle * std::sqrt(std::max(0.0f, glm::dot(v, v) - along * along)) - along * sin_angle;
+				if (dist <= radius && along >= -radius) add_pair(i, light);
+			}
+		}
+
+		//ѹԴݰlight_stridevec4ϴ
+		void upload_lights() {
+			std::vector<glm::vec4> data;
+			data.reserve((point_lights.size() + spot_lights.size()) * light_stride);
+			//ԴΪ180ȵľ۹ƣ۹Ƶ˥ĵԴɫֻҪһּ
+			for (auto& l : point_lights) {
+				data.push_back(glm::vec4(l.pos, -2.0f));
+				data.push_back(glm::vec4(l.ambient, l.constant));
+				data.push_back(glm::vec4(l.diffuse, l.linear));
+				data.push_back(glm::vec4(l.specular, l.quadratic));
+				data.push_back(glm::vec4(0.0f, 0.0f, -1.0f, -1.0f));
+			}
+			for (auto& l : spot_lights) {
+				data.push_back(glm::vec4(l.pos, l.outer_cut_off));
+				data.push_back(glm::vec4(l.ambient, 1.0f));
+				data.push_back(glm::vec4(l.diffuse, 0.0f));
+				data.push_back(glm::vec4(l.specular, 0.0f));
+				data.push_back(glm::vec4(glm::normalize(l.dir), l.cut_off));
+			}
+			light_buf.upload(data.data(), data.size() * sizeof(glm::vec4));
+			lights_dirty = false;
+		}
+
+	public:
+		Clustered() :z_near(0.1f), z_scale(1.0f), lights_dirty(true) {}
+
+		//ͶӰÿصİΧУɫеĳ
+		void init(const Program& prog, int width, int height, float near_plane, float far_plane, const glm::mat4& projection) {
+			z_near = near_plane;
+			z_scale = grid_z / std::log(far_plane / near_plane);
+			cluster_buf = TextureBuffer(GL_RG32UI);
+			index_buf = TextureBuffer(GL_R16UI);
+			light_buf = TextureBuffer(GL_RGBA32F);
+
+			float tan_x = 1.0f / projection[0][0], tan_y = 1.0f / projection[1][1];
+			for (auto* v : { &min_x, &min_y, &min_z, &max_x, &max_y, &max_z }) v->resize(cluster_num);
+			for (int z = 0; z < grid_z; ++z) {
+				float d0 = near_plane * std::exp(z / z_scale), d1 = near_plane * std::exp((z + 1) / z_scale);
+				for (int y = 0; y < grid_y; ++y) {
+					for (int x = 0; x < grid_x; ++x) {
+						unsigned i = (z * grid_y + y) * grid_x + x;
+						float nx0 = 2.0f * x / grid_x - 1.0f, nx1 = 2.0f * (x + 1) / grid_x - 1.0f;
+						float ny0 = 2.0f * y / grid_y - 1.0f, ny1 = 2.0f * (y + 1) / grid_y - 1.0f;
+						//ǽͷ׶壬ΧȡԶķΧ
+						min_x[i] = std::min(nx0 * tan_x * d0, nx0 * tan_x * d1);
+						max_x[i] = std::max(nx1 * tan_x * d0, nx1 * tan_x * d1);
+						min_y[i] = std::min(ny0 * tan_y * d0, ny0 * tan_y * d1);
+						max_y[i] = std::max(ny1 * tan_y * d0, ny1 * tan_y * d1);
+						min_z[i] = -d1;
+						max_z[i] = -d0;
+					}
+				}
+			}
+
+			prog.set("cluster_buf", unit);
+			prog.set("index_buf", unit + 1);
+			prog.set("light_buf", unit + 2);
+			prog.set("screen_size", glm::vec2(width, height));
+			prog.set("z_near", z_near);
+			prog.set("z_scale", z_scale);
+		}
+
+		void add_point_light(const PointLight& light) {
+			if (light_num() >= max_light_num) {
+				std::cerr << "ERROR::CLUSTERED::TOO_MANY_LIGHTS" << std::endl;
+				return;
+			}
+			point_lights.push_back(light);
+			ranges.push_back(light.range());
+			lights_dirty = true;
+		}
+
+		void add_spot_light(const SpotLight& light) {
+			if (light_num() >= max_light_num) {
+				std::cerr << "ERROR::CLUSTERED::TOO_MANY_LIGHTS" << std::endl;
+				return;
+			}
+			spot_lights.push_back(light);
+			lights_dirty = true;
+		}
+
+		unsigned light_num() const { return point_lights.size() + spot_lights.size(); }
+		//һ֡дصĹԴбܳ
+		unsigned get_assigned_num() const { return light_index.size(); }
+
+		//Եǰ·Դϴ
+		void update(const glm::mat4& view) {
+			if (lights_dirty) upload_lights();
+			counts.assign(cluster_num, 0);
+			pair_cluster.clear();
+			pair_light.clear();
+			for (unsigned i = 0; i < point_lights.size(); ++i)
+				bin_sphere(i, glm::vec3(view * glm::vec4(point_lights[i].pos, 1.0f)), ranges[i]);
+			for (unsigned i = 0; i < spot_lights.size(); ++i)
+				bin_cone(point_lights.size() + i, glm::vec3(view * glm::vec4(spot_lights[i].pos, 1.0f)),
+						 glm::normalize(glm::mat3(view) * spot_lights[i].dir), spot_lights[i].outer_cut_off);
+
+			//򣬵õÿĹԴб
+			cluster_data.resize(cluster_num * 2);
+			unsigned offset = 0;
+			for (unsigned i = 0; i < (unsigned)cluster_num; ++i) {
+				cluster_data[i * 2] = offset;
+				cluster_data[i * 2 + 1] = counts[i];
+				offset += counts[i];
+				counts[i] = cluster_data[i * 2];
+			}
+			light_index.resize(offset);
+			for (unsigned i = 0; i < pair_cluster.size(); ++i) light_index[counts[pair_cluster[i]]++] = (uint16_t)pair_light[i];
+
+			cluster_buf.upload(cluster_data.data(), cluster_data.size() * sizeof(unsigned));
+			index_buf.upload(light_index.data(), light_index.size() * sizeof(uint16_t));
+			cluster_buf.bind(unit);
+			index_buf.bind(unit + 1);
+			light_buf.bind(unit + 2);
+		}
+	};
+
+}
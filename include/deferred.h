@@ -0,0 +1,164 @@
+#pragma once
+#include "builder.h"
+#include "light.h"
+#include <vector>
+
+namespace illusion {
+
+	//ӳȾĹղ֣pass֮󣬵ԴģԹֻɫأ
+	//ƽй;۹ƣû˥ȫɫԴɫС
+	class Deferred {
+		static constexpr int unit = 2; //G-buffer󶨵ʼԪ
+		static constexpr float volume_scale = 1.1f; //ֶκĶڣ΢Ŵ֤
+
+		GBuffer gbuffer;
+		Program light_prog; //ɫһԴprogram
+		Program volume_prog; //ǹԴprogramֻ
+		Mesh sphere; //λ
+		unsigned empty_VAO; //ȫõĿVAO
+		std::vector<PointLight> point_lights;
+		std::vector<SpotLight> spot_lights;
+		std::vector<DirLight> dir_lights;
+		unsigned lit_num; //һ֡ʵɫĵԴ
+
+		static Mesh build_sphere() {
+			SphereBuilder builder(glm::vec3(0.0f), 1.0f);
+			builder.build();
+			return Mesh(builder.vertices, builder.indices, nullptr, nullptr, glm::mat4(1.0f));
+		}
+
+		void set_light(const glm::vec3& ambient, const glm::vec3& diffuse, const glm::vec3& specular) {
+			light_prog.set("light.ambient", ambient);
+			light_prog.set("light.diffuse", diffuse);
+			light_prog.set("light.specular", specular);
+		}
+
+		void draw_screen() {
+			light_prog.set("full_screen", 1);
+			glBindVertexArray(empty_VAO);
+			glDrawArrays(GL_TRIANGLES, 0, 3);
+			glBindVertexArray(0);
+		}
+
+		//ģأֻЩɫ
+		void draw_volume(const PointLight& light, float range) {
+			glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), light.pos), glm::vec3(range * volume_scale));
+
+			//󷽡ǰģֵ0
+			glDrawBuffer(GL_NONE);
+			glEnable(GL_DEPTH_TEST);
+			glDisable(GL_CULL_FACE);
+			glDisable(GL_BLEND);
+			glStencilFunc(GL_ALWAYS, 0, 0);
+			glStencilOpSeparate(GL_BACK, GL_KEEP, GL_INCR_WRAP, GL_KEEP);
+			glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_DECR_WRAP, GL_KEEP);
+			sphere.set_model(model);
+			sphere.draw(volume_prog);
+
+			//Ʊ棬ڲʱҲܸǣɫͬʱģֵһԴ
+			glDrawBuffer(GL_COLOR_ATTACHMENT3);
+			glStencilFunc(GL_NOTEQUAL, 0, 0xFF);
+			glStencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
+			glDisable(GL_DEPTH_TEST);
+			glEnable(GL_CULL_FACE);
+			glCullFace(GL_FRONT);
+			glEnable(GL_BLEND);
+			light_prog.set("full_screen", 0);
+			light_prog.set("light_type", 1);
+			light_prog.set("light.pos", light.pos);
+			light_prog.set("light.constant", light.constant);
+			light_prog.set("light.linear", light.linear);
+			light_prog.set("light.quadratic", light.quadratic);
+			set_light(light.ambient, light.diffuse, light.specular);
+			sphere.draw(light_prog);
+			glCullFace(GL_BACK);
+		}
+
+	public:
+		Deferred() :sphere(build_sphere()), empty_VAO(~0), lit_num(0) {}
+		Deferred(const Deferred&) = delete;
+		~Deferred() { if (~empty_VAO) glDeleteVertexArrays(1, &empty_VAO); }
+
+		bool init(int width, int height, const glm::mat4& projection) {
+			Shader vs(GL_VERTEX_SHADER, "./shader/deferred.vs");
+			Shader fs(GL_FRAGMENT_SHADER, "./shader/deferred.fs");
+			Shader volume_vs(GL_VERTEX_SHADER, "./shader/bound.vs");
+			Shader volume_fs(GL_FRAGMENT_SHADER, "./shader/bound.fs");
+			if (vs.fail() || fs.fail() || volume_vs.fail() || volume_fs.fail()
+				|| !light_prog.link(vs, fs) || !volume_prog.link(volume_vs, volume_fs)) return false;
+			gbuffer = GBuffer(width, height);
+			glGenVertexArrays(1, &empty_VAO);
+			light_prog.set("albedo_map", unit);
+			light_prog.set("specular_map", unit + 1);
+			light_prog.set("normal_map", unit + 2);
+			light_prog.set("shininess", 32.0f);
+			light_prog.set("projection", projection);
+			light_prog.set("screen_size", glm::vec2(width, height));
+			light_prog.set("tan_half_fov", glm::vec2(1.0f / projection[0][0], 1.0f / projection[1][1]));
+			volume_prog.set("projection", projection);
+			return true;
+		}
+
+		void add_point_light(const PointLight& light) { point_lights.push_back(light); }
+		void add_spot_light(const SpotLight& light) { spot_lights.push_back(light); }
+		void add_dir_light(const DirLight& light) { dir_lights.push_back(light); }
+
+		unsigned light_num() const { return point_lights.size() + spot_lights.size() + dir_lights.size(); }
+		unsigned get_lit_num() const { return lit_num; }
+
+		//ʼpass
+		void begin_geometry() {
+			gbuffer.use_geometry();
+			glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+		}
+
+		//ۼйԴȸƵĬ֡壬frustum޳ĵԴ
+		void shade(const glm::mat4& view, const glm::vec3& view_pos, const Frustum& frustum, const glm::vec3& background) {
+			gbuffer.use_lighting(unit);
+			glClearColor(background.x, background.y, background.z, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT);
+			light_prog.set("view", view);
+			light_prog.set("inv_view", glm::inverse(view));
+			light_prog.set("view_pos", view_pos);
+			volume_prog.set("view", view);
+
+			glDepthMask(GL_FALSE);
+			glBlendFunc(GL_ONE, GL_ONE);
+			glEnable(GL_STENCIL_TEST);
+			glClear(GL_STENCIL_BUFFER_BIT);
+			lit_num = 0;
+			for (auto& light : point_lights) {
+				float range = light.range();
+				if (!frustum.intersect(AABB(light.pos - range, light.pos + range))) continue;
+				draw_volume(light, range);
+				++lit_num;
+			}
+			glDisable(GL_STENCIL_TEST);
+
+			glDisable(GL_DEPTH_TEST);
+			glEnable(GL_BLEND);
+			for (auto& light : spot_lights) {
+				light_prog.set("light_type", 2);
+				light_prog.set("light.pos", light.pos);
+				light_prog.set("light.dir", light.dir);
+				light_prog.set("light.cut_off", light.cut_off);
+				light_prog.set("light.outer_cut_off", light.outer_cut_off);
+				set_light(light.ambient, light.diffuse, light.specular);
+				draw_screen();
+			}
+			for (auto& light : dir_lights) {
+				light_prog.set("light_type", 0);
+				light_prog.set("light.dir", light.dir);
+				set_light(light.ambient, light.diffuse, light.specular);
+				draw_screen();
+			}
+			glDisable(GL_BLEND);
+			glEnable(GL_DEPTH_TEST);
+			glDepthMask(GL_TRUE);
+
+			gbuffer.blit();
+		}
+	};
+
+}
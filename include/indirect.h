@@ -0,0 +1,216 @@
+#pragma once
+#include "shader.h"
+#include "texture.h"
+#include "sample.h"
+#include "vpl.h"
+
+namespace illusion {
+
+	//ӹԤ裺ӹķֱʺÿصRSM
+	enum class IndirectQuality {
+		LOW, //1/4ֱʣ16β
+		MEDIUM, //1/2ֱʣ32β
+		HIGH, //1/2ֱʣ64β
+		FULL //ȫֱʣ128β
+	};
+
+	//ͷֱʵRSMӹpassÿֻһμӹ⣨Դ޹أ
+	//ͬʱȣɫpassоݴ˽˫ϲ
+	//ʱۻÿֻ֡1/4Ĳÿֻ֡Ӽתǣ
+	//ٰһ֡ĽͶӰǰ֡л
+	class IndirectPass {
+		static constexpr int unit = 9; //ӹͷȰ󶨵ʼԪ
+		static constexpr int history_unit = 6; //ͶӰʱһ֡ĽͷȰ󶨵Ԫ
+		static constexpr float max_history = 16.0f; //ۻ֡
+		static constexpr int temporal_divisor = 4; //ʱۻʱÿ֡ĲΪԤļ֮һ
+		static constexpr float flat_sample_radius = 0.15f; //2D RSMϲԲ̵İ뾶꣩
+
+		Program prog;
+		Program resolve_prog; //ͶӰͻϵprogram
+		Texture current; //֡ļӹ
+		Texture normal_depth[2], history[2]; //֡ʹõķȺۻ
+		unsigned FBO[2], resolve_FBO[2], RBO;
+		unsigned empty_VAO; //ȫõĿVAO
+		int screen_width, screen_height;
+		int width, height; //ӹ⻺ķֱ
+		int sample_num; //ÿصĲ
+		SamplePattern pattern; //ԤɵĲ
+		VplSet vpls; //RSMȡԴʱԲ̲
+
+		bool temporal; //Ƿʱۻ
+		bool history_valid; //һ֡ĽǷ
+		unsigned frame, cur; //֡֡ʹõĻ±
+		glm::mat4 projection, prev_view;
+
+		void release() {
+			for (int i = 0; i < 2; ++i) {
+				if (~FBO[i]) glDeleteFramebuffers(1, &FBO[i]);
+				if (~resolve_FBO[i]) glDeleteFramebuffers(1, &resolve_FBO[i]);
+				FBO[i] = resolve_FBO[i] = ~0;
+			}
+			if (~RBO) glDeleteRenderbuffers(1, &RBO);
+			RBO = ~0;
+		}
+
+		void create(int scale) {
+			release();
+			width = std::max(1, screen_width / scale);
+			height = std::max(1, screen_height / scale);
+			current = Texture(GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST);
+			current.storage(GL_RGBA16F, width, height, GL_FLOAT);
+			glGenRenderbuffers(1, &RBO);
+			glBindRenderbuffer(GL_RENDERBUFFER, RBO);
+			glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+			for (int i = 0; i < 2; ++i) {
+				normal_depth[i] = Texture(GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST);
+				normal_depth[i].storage(GL_RGBA16F, width, height, GL_FLOAT);
+				history[i] = Texture(GL_CLAMP_TO_EDGE, GL_LINEAR, GL_LINEAR);
+				history[i].storage(GL_RGBA16F, width, height, GL_FLOAT);
+
+				glGenFramebuffers(1, &FBO[i]);
+				glBindFramebuffer(GL_FRAMEBUFFER, FBO[i]);
+				glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, current.id(), 0);
+				glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, normal_depth[i].id(), 0);
+				glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, RBO);
+				unsigned attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+				glDrawBuffers(2, attachments);
+				if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+					std::cerr << "ERROR::FRAMEBUFFER::INDIRECT_INCOMPLETE" << std::endl;
+
+				glGenFramebuffers(1, &resolve_FBO[i]);
+				glBindFramebuffer(GL_FRAMEBUFFER, resolve_FBO[i]);
+				glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, history[i].id(), 0);
+				if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+					std::cerr << "ERROR::FRAMEBUFFER::INDIRECT_HISTORY_INCOMPLETE" << std::endl;
+			}
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			history_valid = false;
+		}
+
+		//ͶӰһ֡ۻ뱾֡Ϻдhistory[cur]
+		void resolve(const glm::mat4& view) {
+			glBindFramebuffer(GL_FRAMEBUFFER, resolve_FBO[cur]);
+			glDisable(GL_DEPTH_TEST);
+			current.bind(unit);
+			normal_depth[cur].bind(unit + 1);
+			history[cur ^ 1].bind(history_unit);
+			normal_depth[cur ^ 1].bind(history_unit + 1);
+			resolve_prog.set("inv_view", glm::inverse(view));
+			resolve_prog.set("prev_view", prev_view);
+			resolve_prog.set("prev_view_projection", projection * prev_view);
+			resolve_prog.set("history_valid", history_valid ? 1 : 0);
+			glBindVertexArray(empty_VAO);
+			glDrawArrays(GL_TRIANGLES, 0, 3);
+			glBindVertexArray(0);
+			glEnable(GL_DEPTH_TEST);
+			history_valid = true;
+		}
+
+	public:
+		IndirectPass() :FBO{ ~0u, ~0u }, resolve_FBO{ ~0u, ~0u }, RBO(~0), empty_VAO(~0), screen_width(0), screen_height(0),
+			width(0), height(0), sample_num(64), temporal(true), history_valid(false), frame(0), cur(0) {}
+		IndirectPass(const IndirectPass&) = delete;
+		~IndirectPass() {
+			release();
+			if (~empty_VAO) glDeleteVertexArrays(1, &empty_VAO);
+		}
+
+		bool init(int screen_width, int screen_height, const glm::mat4& projection, int rsm_size, IndirectQuality quality = IndirectQuality::HIGH) {
+			Shader vs(GL_VERTEX_SHADER, "./shader/general_shadow.vs");
+			Shader fs(GL_FRAGMENT_SHADER, "./shader/rsm_indirect.fs");
+			Shader resolve_vs(GL_VERTEX_SHADER, "./shader/deferred.vs");
+			Shader resolve_fs(GL_FRAGMENT_SHADER, "./shader/rsm_temporal.fs");
+			if (vs.fail() || fs.fail() || resolve_vs.fail() || resolve_fs.fail()
+				|| !prog.link(vs, fs) || !resolve_prog.link(resolve_vs, resolve_fs)) return false;
+			this->screen_width = screen_width;
+			this->screen_height = screen_height;
+			this->projection = projection;
+			glGenVertexArrays(1, &empty_VAO);
+			prog.set("projection", projection);
+			prog.set("geometry_map", 12);
+			prog.set("flux_map", 13);
+			prog.set("sample_radius", 1.0f);
+			prog.set("flat_geometry_map", 2);
+			prog.set("flat_flux_map", 3);
+			prog.set("flat_sample_radius", flat_sample_radius);
+			prog.set("rsm_flat", 0);
+			pattern.init();
+			pattern.attach(prog);
+			vpls.init(prog, rsm_size, 1.0f, flat_sample_radius);
+			resolve_prog.set("full_screen", 1);
+			resolve_prog.set("current_map", unit);
+			resolve_prog.set("normal_depth_map", unit + 1);
+			resolve_prog.set("history_map", history_unit);
+			resolve_prog.set("prev_normal_depth_map", history_unit + 1);
+			resolve_prog.set("tan_half_fov", glm::vec2(1.0f / projection[0][0], 1.0f / projection[1][1]));
+			resolve_prog.set("max_history", max_history);
+			set_quality(quality);
+			return true;
+		}
+
+		void set_quality(IndirectQuality quality) {
+			switch (quality) {
+			case IndirectQuality::LOW: create(4), sample_num = 16; break;
+			case IndirectQuality::MEDIUM: create(2), sample_num = 32; break;
+			case IndirectQuality::HIGH: create(2), sample_num = 64; break;
+			default: create(1), sample_num = SamplePattern::max_sample_num; break;
+			}
+		}
+
+		void set_temporal(bool value) {
+			temporal = value;
+			history_valid = false;
+		}
+
+		//VPL0ʾرVPLʹԲ̲
+		void set_vpl_num(int num) {
+			vpls.set_cluster_num(prog, num);
+			history_valid = false;
+		}
+
+		//RSM»ƺã첽RSMȡVPL
+		void request_vpls(const FullFrameBuffer& rsm, const glm::vec3& light_pos) { vpls.request(rsm, light_pos); }
+		void request_vpls(const FlatFrameBuffer& rsm, const glm::mat4& inv_view, const glm::vec2& scale, bool ortho) {
+			vpls.request(rsm, inv_view, scale, ortho);
+		}
+
+		const VplSet& get_vpls() const { return vpls; }
+
+		Program& program() { return prog; }
+
+		//ʼƼӹ⣬֮program()ɼ
+		void begin(const glm::mat4& view) {
+			++frame;
+			cur ^= 1;
+			glBindFramebuffer(GL_FRAMEBUFFER, FBO[cur]);
+			glViewport(0, 0, width, height);
+			glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			prog.set("view", view);
+			//ʱۻʱÿֻ֡Ӽûƽתײ
+			int num = temporal ? std::max(1, sample_num / temporal_divisor) : sample_num;
+			float angle = temporal ? frame * 2.39996323f : 0.0f;
+			prog.set("sample_num", num);
+			prog.set("sample_offset", temporal ? int(frame * num % SamplePattern::max_sample_num) : 0);
+			prog.set("frame_rotation", glm::vec2(std::cos(angle), std::sin(angle)));
+			pattern.bind();
+			vpls.update(prog);
+			vpls.bind();
+		}
+
+		//ƣѽ󶨸ɫpassprogram
+		void end(const Program& target, const glm::mat4& view) {
+			if (temporal) resolve(view);
+			prev_view = view;
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			glViewport(0, 0, screen_width, screen_height);
+			if (temporal) history[cur].bind(unit);
+			else current.bind(unit);
+			normal_depth[cur].bind(unit + 1);
+			target.set("indirect_low", unit);
+			target.set("normal_depth_low", unit + 1);
+			target.set("indirect_scale", glm::vec2(float(width) / screen_width, float(height) / screen_height));
+		}
+	};
+
+}
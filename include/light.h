@@ -1,5 +1,6 @@
 #pragma once
 #include <glm/glm.hpp>
+#include <cmath>
 
 namespace illusion {
 
@@ -15,6 +16,16 @@ namespace illusion {
 
 		PointLight(const glm::vec3& pos) :pos(pos), constant(1.0f), linear(0.09f), quadratic(0.032f),
 			ambient(glm::vec3(0.3f, 0.3f, 0.3f)), diffuse(glm::vec3(1, 1, 1)), specular(glm::vec3(1, 1, 1)) {}
+
+		//վ˥thresholdľ룬ԴӰ뾶
+		float range(float threshold = 1.0f / 256.0f) const {
+			glm::vec3 color = glm::max(glm::max(ambient, diffuse), specular);
+			float k = constant - glm::max(color.x, glm::max(color.y, color.z)) / threshold;
+			if (k >= 0.0f) return 0.0f;
+			if (quadratic > 0.0f) return (-linear + std::sqrt(linear * linear - 4.0f * quadratic * k)) / (2.0f * quadratic);
+			if (linear > 0.0f) return -k / linear;
+			return 1e30f; //˥
+		}
 	};
 
 	//ƽй
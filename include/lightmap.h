@@ -0,0 +1,522 @@
+#pragma once
+#include "mesh.h"
+#include "light.h"
+#include "tracer.h"
+#include "parallel.h"
+#include <fstream>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <array>
+#include <chrono>
+#include <cstring>
+
+namespace illusion {
+
+	//CPU決Ĺͼ̬尴ֳƽchartͶӰchartƽһͼУ
+	//ÿtexel4BVH϶߳·׷ֱӹͶηļӹ⣬ѹRGB9E5
+	//ɫʱÿƬֻһ決д뻺ļ͹ԴʱֱӶȡ
+	class Lightmap {
+	public:
+		static constexpr int size = 512; //ͼķֱ
+
+	private:
+		static constexpr int unit = 9; //ͼ󶨵Ԫ
+		static constexpr int padding = 2; //chart֮texel決չ˫Թ˲ɵchart
+		static constexpr float fill = 0.5f; //ʱchartռͼĿ
+		static constexpr float chart_cos = 0.7f; //chartӷнǵ
+		static constexpr int sample_num = 64; //ÿtexelļӹ·
+		static constexpr int bounce_num = 3; //ÿ·󷴵
+		static constexpr unsigned magic = 0x31504D4C; //ļıʶ"LMP1"
+
+		//ļͷ뵱ǰȫһʱʹû
+		struct Header {
+			unsigned magic;
+			int size, sample_num, bounce_num;
+			unsigned object_num, triangle_num;
+			unsigned hash; //Ρʺ͹ԴFNV-1aϣ
+		};
+
+		//ͬһchartڵͶӰͬһƽ
+		struct Chart {
+			unsigned object;
+			glm::vec2 min, max; //ͶӰķΧռ䵥λ
+			int x, y, w, h; //ͼеλúʹСtexelpadding
+		};
+
+		struct Object {
+			std::vector<glm::vec3> positions, normals; //ֺģͿռĶ
+			std::vector<unsigned> indices;
+			std::vector<glm::vec2> plane; //ÿchartƽϵͶӰ
+			std::vector<unsigned> chart_of; //ÿchart
+			std::vector<glm::vec2> coords; //Ĺͼ
+			glm::mat4 model;
+			glm::vec3 albedo; //ƽɫ
+		};
+
+		//󽻺ȡõı
+		struct Surface {
+			glm::vec3 normal; //ռļη
+			glm::vec3 albedo;
+		};
+
+		//ÿ̶߳
+		struct Random {
+			unsigned state;
+			explicit Random(unsigned seed) :state(seed * 747796405u + 2891336453u) { next(); }
+			unsigned next() {
+				state ^= state << 13;
+				state ^= state >> 17;
+				state ^= state << 5;
+				return state;
+			}
+			float uniform() { return (next() >> 8) * (1.0f / 16777216.0f); }
+		};
+
+		std::vector<Object> objects;
+		std::vector<Chart> charts;
+		std::vector<PointLight> point_lights;
+		std::vector<SpotLight> spot_lights;
+		std::vector<DirLight> dir_lights;
+		TriangleBVH bvh;
+		std::vector<Surface> surfaces; //bvhÿεı
+		std::vector<unsigned> texels; //RGB9E5Ľ
+		Texture tex;
+		std::string path; //ļ·
+		float texel_size; //һtexelӦռ䳤
+		float offset; //طƫƣཻ
+		bool laid_out; //chartǷѾ
+		bool ready; //ͼǷ
+		bool use_cache; //Ƿȡ
+		float bake_ms; //һκ決ĺʱ룩
+
+		static unsigned fnv(unsigned hash, const void* data, size_t bytes) {
+			const unsigned char* p = (const unsigned char*)data;
+			for (size_t i = 0; i < bytes; ++i) hash = (hash ^ p[i]) * 16777619u;
+			return hash;
+		}
+
+		//GL_EXT_texture_shared_exponentĹ룬ͨ5λָ9λβ
+		static unsigned encode_rgb9e5(const glm::vec3& color) {
+			constexpr float max_value = 511.0f / 512.0f * 65536.0f;
+			glm::vec3 c = glm::clamp(color, glm::vec3(0.0f), glm::vec3(max_value));
+			float m = std::max(c.r, std::max(c.g, c.b));
+			if (m <= 0.0f) return 0;
+			int e = std::max(-16, (int)std::floor(std::log2(m))) + 16;
+			float denom = std::ldexp(1.0f, e - 24);
+			if ((int)std::floor(m / denom + 0.5f) == 512) denom *= 2.0f, ++e;
+			unsigned r = (unsigned)std::floor(c.r / denom + 0.5f);
+			unsigned g = (unsigned)std::floor(c.g / denom + 0.5f);
+			unsigned b = (unsigned)std::floor(c.b / denom + 0.5f);
+			return std::min(r, 511u) | std::min(g, 511u) << 9 | std::min(b, 511u) << 18 | unsigned(e) << 27;
+		}
+
+		//nֱλ
+		static void basis(const glm::vec3& n, glm::vec3& t, glm::vec3& b) {
+			t = glm::normalize(glm::cross(std::abs(n.y) < 0.99f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f), n));
+			b = glm::cross(n, t);
+		}
+
+		//ֳchartchart֮乲õĶ㣬source¼ÿ¶Ӧԭ
+		void unwrap(Object& obj, const std::vector<Vertex>& vertices, const std::vector<unsigned>& indices, std::vector<unsigned>& source) {
+			unsigned tri_num = indices.size() / 3;
+			std::vector<glm::vec3> world(vertices.size());
+			for (unsigned i = 0; i < vertices.size(); ++i) world[i] = glm::vec3(obj.model * glm::vec4(vertices[i].position, 1.0f));
+			std::vector<glm::vec3> face_normal(tri_num);
+			for (unsigned i = 0; i < tri_num; ++i) {
+				const unsigned* v = &indices[i * 3];
+				glm::vec3 n = glm::cross(world[v[1]] - world[v[0]], world[v[2]] - world[v[0]]);
+				float len = glm::length(n);
+				face_normal[i] = len > 0.0f ? n / len : glm::vec3(0.0f);
+			}
+
+			//λúӶεڽӹϵbuilderɵģͨÿжĶ
+			std::map<std::array<long long, 3>, unsigned> weld_map;
+			std::vector<unsigned> weld(vertices.size());
+			for (unsigned i = 0; i < vertices.size(); ++i) {
+				std::array<long long, 3> key;
+				for (int j = 0; j < 3; ++j) key[j] = std::llround(world[i][j] * 1e4f);
+				weld[i] = weld_map.emplace(key, (unsigned)weld_map.size()).first->second;
+			}
+			std::unordered_map<unsigned long long, std::vector<unsigned>> edges;
+			for (unsigned i = 0; i < tri_num; ++i)
+				for (int j = 0; j < 3; ++j) {
+					unsigned a = weld[indices[i * 3 + j]], b = weld[indices[i * 3 + (j + 1) % 3]];
+					if (a == b) continue;
+					if (a > b) std::swap(a, b);
+					edges[(unsigned long long)a << 32 | b].push_back(i);
+				}
+			std::vector<std::vector<unsigned>> adjacent(tri_num);
+			for (auto& e : edges)
+				for (unsigned x : e.second)
+					for (unsigned y : e.second)
+						if (x != y) adjacent[x].push_back(y);
+
+			//οʼչӽӽβͬһchart
+			//ζӵķͶӰ䴹ֱƽϲᷭת
+			std::vector<unsigned> chart_of_tri(tri_num, ~0u), queue;
+			std::vector<unsigned> seeds;
+			for (unsigned i = 0; i < tri_num; ++i) {
+				if (~chart_of_tri[i]) continue;
+				unsigned chart = seeds.size();
+				seeds.push_back(i);
+				glm::vec3 n = face_normal[i];
+				chart_of_tri[i] = chart;
+				queue.assign(1, i);
+				for (size_t head = 0; head < queue.size(); ++head)
+					for (unsigned j : adjacent[queue[head]])
+						if (!~chart_of_tri[j] && glm::dot(face_normal[j], n) > chart_cos) {
+							chart_of_tri[j] = chart;
+							queue.push_back(j);
+						}
+			}
+
+			//ÿchartӵԼĶ㸱
+			unsigned first_chart = charts.size();
+			for (unsigned c = 0; c < seeds.size(); ++c) charts.push_back(Chart{ (unsigned)(&obj - objects.data()), glm::vec2(FLT_MAX), glm::vec2(-FLT_MAX), 0, 0, 0, 0 });
+			std::vector<glm::vec3> tangent(seeds.size()), bitangent(seeds.size());
+			for (unsigned c = 0; c < seeds.size(); ++c) {
+				glm::vec3 n = face_normal[seeds[c]];
+				if (n == glm::vec3(0.0f)) n = glm::vec3(0.0f, 1.0f, 0.0f);
+				basis(n, tangent[c], bitangent[c]);
+			}
+			std::map<std::pair<unsigned, unsigned>, unsigned> split; //(chart, ԭ) -> ¶
+			obj.indices.resize(tri_num * 3);
+			for (unsigned i = 0; i < tri_num; ++i) {
+				unsigned c = chart_of_tri[i];
+				for (int j = 0; j < 3; ++j) {
+					unsigned v = indices[i * 3 + j];
+					auto it = split.emplace(std::make_pair(c, v), (unsigned)obj.positions.size());
+					if (it.second) {
+						source.push_back(v);
+						obj.positions.push_back(vertices[v].position);
+						obj.normals.push_back(vertices[v].normal);
+						glm::vec2 p(glm::dot(world[v], tangent[c]), glm::dot(world[v], bitangent[c]));
+						obj.plane.push_back(p);
+						obj.chart_of.push_back(first_chart + c);
+						Chart& chart = charts[first_chart + c];
+						chart.min = glm::min(chart.min, p);
+						chart.max = glm::max(chart.max, p);
+					}
+					obj.indices[i * 3 + j] = it.first->second;
+				}
+			}
+		}
+
+		//texel_sizeÿchartĴС߶ȴӴСдǷŵ
+		bool pack() {
+			for (auto& c : charts) {
+				glm::vec2 extent = (c.max - c.min) / texel_size;
+				c.w = (int)std::ceil(extent.x) + 1 + padding * 2;
+				c.h = (int)std::ceil(extent.y) + 1 + padding * 2;
+			}
+			std::vector<unsigned> order(charts.size());
+			for (unsigned i = 0; i < order.size(); ++i) order[i] = i;
+			std::sort(order.begin(), order.end(), [this](unsigned a, unsigned b) { return charts[a].h > charts[b].h; });
+			int x = 0, y = 0, row = 0;
+			for (unsigned id : order) {
+				Chart& c = charts[id];
+				if (c.w > size) return false;
+				if (x + c.w > size) x = 0, y += row, row = 0;
+				if (y + c.h > size) return false;
+				c.x = x, c.y = y;
+				x += c.w;
+				row = std::max(row, c.h);
+			}
+			return true;
+		}
+
+		//ݳѡtexelСŲʱȻÿĹͼ
+		bool layout() {
+			float area = 0.0f;
+			for (auto& c : charts) {
+				glm::vec2 e = c.max - c.min;
+				area += std::max(e.x, 1e-6f) * std::max(e.y, 1e-6f);
+			}
+			texel_size = std::sqrt(area / (fill * size * size));
+			if (!(texel_size > 0.0f)) texel_size = 1.0f;
+			int tries = 0;
+			while (!pack()) {
+				texel_size *= 1.15f;
+				if (++tries == 64) {
+					std::cerr << "ERROR::LIGHTMAP::ATLAS_FULL" << std::endl;
+					return false;
+				}
+			}
+			for (auto& obj : objects) {
+				obj.coords.resize(obj.plane.size());
+				for (unsigned i = 0; i < obj.plane.size(); ++i) {
+					const Chart& c = charts[obj.chart_of[i]];
+					glm::vec2 texel = glm::vec2(c.x + padding, c.y + padding) + 0.5f + (obj.plane[i] - c.min) / texel_size;
+					obj.coords[i] = texel / float(size);
+				}
+			}
+			return true;
+		}
+
+		//ռμԣڹBVHͼ㻺Ĺϣ
+		unsigned collect(std::vector<glm::vec3>& positions) {
+			positions.clear();
+			surfaces.clear();
+			unsigned hash = 2166136261u;
+			for (auto& obj : objects) {
+				for (unsigned i = 0; i + 2 < obj.indices.size(); i += 3) {
+					glm::vec3 v[3];
+					for (int j = 0; j < 3; ++j) v[j] = glm::vec3(obj.model * glm::vec4(obj.positions[obj.indices[i + j]], 1.0f));
+					glm::vec3 n = glm::cross(v[1] - v[0], v[2] - v[0]);
+					float len = glm::length(n);
+					positions.insert(positions.end(), v, v + 3);
+					surfaces.push_back(Surface{ len > 0.0f ? n / len : glm::vec3(0.0f, 1.0f, 0.0f), obj.albedo });
+					hash = fnv(hash, v, sizeof(v));
+				}
+				hash = fnv(hash, &obj.albedo, sizeof(obj.albedo));
+			}
+			for (auto& l : point_lights) hash = fnv(hash, &l, sizeof(l));
+			for (auto& l : spot_lights) hash = fnv(hash, &l, sizeof(l));
+			for (auto& l : dir_lights) hash = fnv(hash, &l, sizeof(l));
+			return hash;
+		}
+
+		//ʵʱɫһµֱӹ⣨ʣÿԴһӰ
+		glm::vec3 direct(const glm::vec3& pos, const glm::vec3& normal) const {
+			glm::vec3 ret(0.0f), origin = pos + normal * offset;
+			for (auto& l : point_lights) {
+				glm::vec3 d = l.pos - pos;
+				float dist = glm::length(d);
+				float diff = glm::dot(normal, d) / dist;
+				if (diff <= 0.0f || bvh.occluded(origin, d / dist, dist)) continue;
+				ret += l.diffuse * diff / (l.constant + l.linear * dist + l.quadratic * dist * dist);
+			}
+			for (auto& l : spot_lights) {
+				glm::vec3 d = l.pos - pos;
+				float dist = glm::length(d);
+				glm::vec3 dir = d / dist;
+				float diff = glm::dot(normal, dir);
+				float intensity = glm::clamp((glm::dot(dir, glm::normalize(-l.dir)) - l.outer_cut_off) / (l.cut_off - l.outer_cut_off), 0.0f, 1.0f);
+				if (diff <= 0.0f || intensity <= 0.0f || bvh.occluded(origin, dir, dist)) continue;
+				ret += l.diffuse * diff * intensity;
+			}
+			for (auto& l : dir_lights) {
+				glm::vec3 dir = glm::normalize(-l.dir);
+				float diff = glm::dot(normal, dir);
+				if (diff <= 0.0f || bvh.occluded(origin, dir, FLT_MAX)) continue;
+				ret += l.diffuse * diff;
+			}
+			return ret;
+		}
+
+		//ҷֲһ·;ηֱӹ⣬Ҳʱܶcos / pi
+		glm::vec3 indirect(glm::vec3 pos, glm::vec3 normal, Random& rng) const {
+			glm::vec3 ret(0.0f), throughput(1.0f);
+			for (int i = 0; i < bounce_num; ++i) {
+				float phi = 2.0f * glm::pi<float>() * rng.uniform(), r2 = rng.uniform(), r = std::sqrt(r2);
+				glm::vec3 t, b;
+				basis(normal, t, b);
+				glm::vec3 dir = t * (r * std::cos(phi)) + b * (r * std::sin(phi)) + normal * std::sqrt(1.0f - r2);
+				glm::vec3 origin = pos + normal * offset;
+				float dist;
+				unsigned hit;
+				if (!bvh.closest(origin, dir, dist, hit)) break;
+				const Surface& s = surfaces[hit];
+				pos = origin + dir * dist;
+				normal = glm::dot(s.normal, dir) > 0.0f ? -s.normal : s.normal;
+				throughput *= s.albedo;
+				ret += throughput * direct(pos, normal);
+				if (std::max(throughput.r, std::max(throughput.g, throughput.b)) < 1e-3f) break;
+			}
+			return ret;
+		}
+
+		//ιդͼtexelϣtexelĲκʱȡ벻һtexel
+		void rasterize(std::vector<glm::vec3>& pos, std::vector<glm::vec3>& normal, std::vector<float>& dist) const {
+			pos.assign(size * size, glm::vec3(0.0f));
+			normal.assign(size * size, glm::vec3(0.0f));
+			dist.assign(size * size, FLT_MAX);
+			glm::mat3 normal_matrix;
+			for (auto& obj : objects) {
+				normal_matrix = glm::transpose(glm::inverse(glm::mat3(obj.model)));
+				for (unsigned i = 0; i + 2 < obj.indices.size(); i += 3) {
+					const unsigned* v = &obj.indices[i];
+					glm::vec2 p[3];
+					for (int j = 0; j < 3; ++j) p[j] = obj.coords[v[j]] * float(size);
+					float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[2].x - p[0].x) * (p[1].y - p[0].y);
+					glm::vec2 lo = glm::min(p[0], glm::min(p[1], p[2])) - 1.0f, hi = glm::max(p[0], glm::max(p[1], p[2])) + 1.0f;
+					int x0 = std::max((int)std::floor(lo.x), 0), x1 = std::min((int)std::ceil(hi.x), size - 1);
+					int y0 = std::max((int)std::floor(lo.y), 0), y1 = std::min((int)std::ceil(hi.y), size - 1);
+					for (int y = y0; y <= y1; ++y)
+						for (int x = x0; x <= x1; ++x) {
+							glm::vec2 c(x + 0.5f, y + 0.5f);
+							glm::vec3 w;
+							if (std::abs(area) > 1e-12f) {
+								w[1] = ((c.x - p[0].x) * (p[2].y - p[0].y) - (p[2].x - p[0].x) * (c.y - p[0].y)) / area;
+								w[2] = ((p[1].x - p[0].x) * (c.y - p[0].y) - (c.x - p[0].x) * (p[1].y - p[0].y)) / area;
+								w[0] = 1.0f - w[1] - w[2];
+							} else w = glm::vec3(1.0f / 3.0f);
+							//ʱضϵϣýضϵ㵽ĵľǷ
+							glm::vec3 clamped = glm::max(w, glm::vec3(0.0f));
+							clamped /= clamped.x + clamped.y + clamped.z;
+							float d = glm::length(p[0] * clamped.x + p[1] * clamped.y + p[2] * clamped.z - c);
+							int id = y * size + x;
+							if (d > 1.0f || d >= dist[id]) continue;
+							dist[id] = d;
+							pos[id] = glm::vec3(obj.model * glm::vec4(obj.positions[v[0]] * clamped.x + obj.positions[v[1]] * clamped.y + obj.positions[v[2]] * clamped.z, 1.0f));
+							glm::vec3 n = obj.normals[v[0]] * clamped.x + obj.normals[v[1]] * clamped.y + obj.normals[v[2]] * clamped.z;
+							normal[id] = glm::length(n) > 0.0f ? glm::normalize(normal_matrix * n) : glm::vec3(0.0f);
+						}
+				}
+			}
+		}
+
+		void bake() {
+			std::vector<glm::vec3> pos, normal;
+			std::vector<float> dist;
+			rasterize(pos, normal, dist);
+			std::vector<unsigned> work;
+			for (unsigned i = 0; i < pos.size(); ++i) if (normal[i] != glm::vec3(0.0f)) work.push_back(i);
+
+			//Чtexelʹ̵߳ĸؽӽ
+			std::vector<glm::vec3> color(size * size, glm::vec3(0.0f));
+			parallel_for(work.size(), [&](unsigned begin, unsigned end) {
+				for (unsigned i = begin; i < end; ++i) {
+					unsigned id = work[i];
+					Random rng(id);
+					glm::vec3 sum(0.0f);
+					for (int s = 0; s < sample_num; ++s) sum += indirect(pos[id], normal[id], rng);
+					color[id] = direct(pos[id], normal[id]) + sum / float(sample_num);
+				}
+			}, 64);
+
+			//չpaddingȦδǵtexelȡѸtexelƽֵ
+			std::vector<char> covered(size * size, 0);
+			for (unsigned id : work) covered[id] = 1;
+			for (int k = 0; k < padding; ++k) {
+				std::vector<char> next = covered;
+				for (int y = 0; y < size; ++y)
+					for (int x = 0; x < size; ++x) {
+						if (covered[y * size + x]) continue;
+						glm::vec3 sum(0.0f);
+						int n = 0;
+						for (int dy = -1; dy <= 1; ++dy)
+							for (int dx = -1; dx <= 1; ++dx) {
+								int nx = x + dx, ny = y + dy;
+								if (nx < 0 || ny < 0 || nx >= size || ny >= size || !covered[ny * size + nx]) continue;
+								sum += color[ny * size + nx];
+								++n;
+							}
+						if (n) color[y * size + x] = sum / float(n), next[y * size + x] = 1;
+					}
+				covered.swap(next);
+			}
+			texels.resize(size * size);
+			for (int i = 0; i < size * size; ++i) texels[i] = encode_rgb9e5(color[i]);
+		}
+
+		bool load(const Header& cur) {
+			std::ifstream fin(path, std::ios::binary);
+			if (!fin) return false;
+			Header h;
+			fin.read((char*)&h, sizeof(h));
+			if (!fin || std::memcmp(&h, &cur, sizeof(h))) return false;
+			texels.resize(size * size);
+			fin.read((char*)texels.data(), texels.size() * sizeof(unsigned));
+			if (!fin) {
+				std::cerr << "ERROR::LIGHTMAP::CACHE_TRUNCATED  " << path << std::endl;
+				return false;
+			}
+			return true;
+		}
+
+		void save(const Header& h) const {
+			std::ofstream fout(path, std::ios::binary);
+			if (!fout) {
+				std::cerr << "ERROR::LIGHTMAP::CACHE_WRITING_FAILED  " << path << std::endl;
+				return;
+			}
+			fout.write((const char*)&h, sizeof(h));
+			fout.write((const char*)texels.data(), texels.size() * sizeof(unsigned));
+		}
+
+	public:
+		Lightmap() :texel_size(1.0f), offset(1e-4f), laid_out(false), ready(false), use_cache(true), bake_ms(0.0f) {}
+		Lightmap(const Lightmap&) = delete;
+
+		bool init(const Program& target, const char* cache_path) {
+			path = cache_path;
+			tex = Texture(GL_CLAMP_TO_EDGE, GL_LINEAR, GL_LINEAR);
+			if (tex.fail()) return false;
+			target.set("lightmap", unit);
+			target.set("use_lightmap", 1);
+			return true;
+		}
+
+		//һ̬壬زֶverticesindicesǴmeshalbedoΪƽɫ
+		void add(const std::vector<Vertex>& vertices, const std::vector<unsigned>& indices, const glm::mat4& model, const glm::vec3& albedo,
+				 std::vector<Vertex>& out_vertices, std::vector<unsigned>& out_indices) {
+			objects.emplace_back();
+			Object& obj = objects.back();
+			obj.model = model;
+			obj.albedo = albedo;
+			std::vector<unsigned> source;
+			unwrap(obj, vertices, indices, source);
+			out_vertices.resize(source.size());
+			for (unsigned i = 0; i < source.size(); ++i) out_vertices[i] = vertices[source[i]];
+			out_indices = obj.indices;
+			laid_out = false;
+			ready = false;
+		}
+
+		//¼µı任󣬹ͼֻ´rebakeʱµλú決
+		void set_model(unsigned id, const glm::mat4& model) { objects[id].model = model; }
+
+		void set_lights(const std::vector<PointLight>& point, const std::vector<SpotLight>& spot, const std::vector<DirLight>& dir) {
+			point_lights = point;
+			spot_lights = spot;
+			dir_lights = dir;
+		}
+
+		//һprepareʱԻº決
+		void rebake() {
+			ready = false;
+			use_cache = false;
+		}
+
+		//Ҫʱchartȡ決󶨵ɫpassʹõԪϣǷ決
+		//ÿupload(id, coords)ϴͼ
+		template<typename F>
+		bool prepare(F&& upload) {
+			bool baked = false;
+			if (!laid_out && !objects.empty()) {
+				if (!layout()) return false;
+				for (unsigned i = 0; i < objects.size(); ++i) upload(i, objects[i].coords);
+				laid_out = true;
+			}
+			if (!ready && laid_out) {
+				std::vector<glm::vec3> positions;
+				unsigned hash = collect(positions);
+				Header h{ magic, size, sample_num, bounce_num, (unsigned)objects.size(), (unsigned)surfaces.size(), hash };
+				if (!use_cache || !load(h)) {
+					auto start = std::chrono::steady_clock::now();
+					AABB scene;
+					for (auto& p : positions) scene.extend(p);
+					offset = std::max(scene.radius() * 1e-4f, 1e-5f);
+					bvh.build(positions);
+					bake();
+					bake_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+					save(h);
+					baked = true;
+				}
+				tex.bind(unit);
+				glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB9_E5, size, size, 0, GL_RGB, GL_UNSIGNED_INT_5_9_9_9_REV, texels.data());
+				ready = true;
+				use_cache = true;
+			}
+			tex.bind(unit);
+			return baked;
+		}
+
+		float get_bake_ms() const { return bake_ms; }
+		float get_texel_size() const { return texel_size; }
+		unsigned chart_num() const { return charts.size(); }
+	};
+
+}
@@ -0,0 +1,176 @@
+#pragma once
+#include "shader.h"
+#include "texture.h"
+#include "bound.h"
+
+namespace illusion {
+
+	//⴫LPVRSMtexelΪԴע뵽ǳ3DУ
+	//ÿL1гÿɫͨ4ϵʾøӵķǿȣ
+	//ڸӼɴΣɫʱÿƬֻһԲ
+	//RSMʱҪעʹÿ֡ĿֻɫʱĲ
+	class LightVolume {
+	public:
+		static constexpr int size = 32; //ÿһάĸ
+
+	private:
+		static constexpr int unit = 9; //ۻ3󶨵ʼԪ
+		static constexpr int inject_size = 64; //עʱȡRSM㼶ÿֱ
+		static constexpr int propagation_num = 8; //ĵ
+		static constexpr float intensity = 1.0f; //ɫʱӹǿ
+
+		Program inject_prog, propagate_prog;
+		unsigned tex[3][3]; //ע/ʹõۻÿֱ𱣴RGBͨϵ
+		unsigned FBO[3]; //ֱд01飬ͬʱۼӵۻ
+		unsigned empty_VAO;
+		int level; //עʱȡRSM㼶
+		int rsm_face; //ò㼶ÿķֱ
+		AABB box; //񸲸ǵķΧ
+		float cell; //ӵı߳
+		bool dirty;
+
+		void bind_group(int group, int first) const {
+			for (int i = 0; i < 3; ++i) {
+				glActiveTexture(GL_TEXTURE0 + first + i);
+				glBindTexture(GL_TEXTURE_3D, tex[group][i]);
+			}
+		}
+
+	public:
+		LightVolume() :tex{}, FBO{ ~0u, ~0u, ~0u }, empty_VAO(~0), level(0), rsm_face(1), cell(1.0f), dirty(true) {
+			for (auto& g : tex) for (auto& t : g) t = ~0;
+		}
+		LightVolume(const LightVolume&) = delete;
+		~LightVolume() {
+			for (auto& f : FBO) if (~f) glDeleteFramebuffers(1, &f);
+			for (auto& g : tex) for (auto& t : g) if (~t) glDeleteTextures(1, &t);
+			if (~empty_VAO) glDeleteVertexArrays(1, &empty_VAO);
+		}
+
+		//rsm_sizeΪRSMķֱʣRSMgeometryfluxrsm_unitrsm_unit + 1
+		bool init(const Program& target, int rsm_size, int rsm_unit) {
+			Shader inject_vs(GL_VERTEX_SHADER, "./shader/lpv_inject.vs");
+			Shader inject_gs(GL_GEOMETRY_SHADER, "./shader/lpv_inject.gs");
+			Shader inject_fs(GL_FRAGMENT_SHADER, "./shader/lpv_inject.fs");
+			Shader propagate_vs(GL_VERTEX_SHADER, "./shader/lpv_propagate.vs");
+			Shader propagate_gs(GL_GEOMETRY_SHADER, "./shader/lpv_propagate.gs");
+			Shader propagate_fs(GL_FRAGMENT_SHADER, "./shader/lpv_propagate.fs");
+			if (inject_vs.fail() || inject_gs.fail() || inject_fs.fail() || propagate_vs.fail() || propagate_gs.fail() || propagate_fs.fail()
+				|| !inject_prog.link(inject_vs, inject_fs, inject_gs) || !propagate_prog.link(propagate_vs, propagate_fs, propagate_gs)) return false;
+			while ((rsm_size >> level) > inject_size) ++level;
+			rsm_face = std::max(rsm_size >> level, 1);
+
+			for (int g = 0; g < 3; ++g) {
+				glGenTextures(3, tex[g]);
+				for (int i = 0; i < 3; ++i) {
+					glActiveTexture(GL_TEXTURE15);
+					glBindTexture(GL_TEXTURE_3D, tex[g][i]);
+					glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA16F, size, size, size, 0, GL_RGBA, GL_FLOAT, NULL);
+					//ʱtexelFetchȡֻۻҪԹ
+					GLint filter = g == 2 ? GL_LINEAR : GL_NEAREST;
+					glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, filter);
+					glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, filter);
+					glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+					glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+					glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+				}
+			}
+			//ǰ3Ϊдһ飬3ۼӵۻ
+			unsigned attachments[6];
+			for (int i = 0; i < 6; ++i) attachments[i] = GL_COLOR_ATTACHMENT0 + i;
+			glGenFramebuffers(3, FBO);
+			for (int g = 0; g < 2; ++g) {
+				glBindFramebuffer(GL_FRAMEBUFFER, FBO[g]);
+				for (int i = 0; i < 3; ++i) {
+					glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, tex[g][i], 0);
+					glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT3 + i, tex[2][i], 0);
+				}
+				glDrawBuffers(6, attachments);
+				if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+					std::cerr << "ERROR::FRAMEBUFFER::LIGHT_VOLUME_INCOMPLETE" << std::endl;
+			}
+			//ֻۻ
+			glBindFramebuffer(GL_FRAMEBUFFER, FBO[2]);
+			for (int i = 0; i < 3; ++i) glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, tex[2][i], 0);
+			glDrawBuffers(3, attachments);
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			glGenVertexArrays(1, &empty_VAO);
+
+			inject_prog.set("geometry_map", rsm_unit);
+			inject_prog.set("flux_map", rsm_unit + 1);
+			inject_prog.set("rsm_level", float(level));
+			inject_prog.set("rsm_face", rsm_face);
+			inject_prog.set("volume_size", size);
+			//RSMԲ̲ȱһ£Բ̲ĽԼpi * s^2 / 4texelƽֵ
+			inject_prog.set("flux_scale", 4.0f / (glm::pi<float>() * rsm_face * rsm_face));
+			propagate_prog.set("volume_size", size);
+			propagate_prog.set("sh_r", 5);
+			propagate_prog.set("sh_g", 6);
+			propagate_prog.set("sh_b", 7);
+			target.set("lpv_r", unit);
+			target.set("lpv_g", unit + 1);
+			target.set("lpv_b", unit + 2);
+			target.set("lpv_intensity", intensity);
+			return true;
+		}
+
+		//񸲸boxΪ壬boxһάһ
+		void set_bounds(const Program& target, const AABB& scene) {
+			if (scene.empty()) return;
+			glm::vec3 extent = scene.max - scene.min;
+			cell = std::max(std::max(extent.x, extent.y), std::max(extent.z, 1e-3f)) / (size - 2);
+			glm::vec3 half(cell * size * 0.5f);
+			box = AABB(scene.center() - half, scene.center() + half);
+			target.set("lpv_min", box.min);
+			target.set("lpv_extent", box.max - box.min);
+			target.set("lpv_cell", cell);
+			dirty = true;
+		}
+
+		//RSM»ƺ
+		void invalidate() { dirty = true; }
+
+		//Ҫʱעʹۻ󶨵ɫpassʹõԪϣǷ¼
+		bool update(const glm::vec3& light_pos) {
+			bool ret = dirty;
+			if (dirty) {
+				glDisable(GL_DEPTH_TEST);
+				glDisable(GL_CULL_FACE);
+				glViewport(0, 0, size, size);
+				glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+				glBindFramebuffer(GL_FRAMEBUFFER, FBO[2]);
+				glClear(GL_COLOR_BUFFER_BIT);
+				glBindFramebuffer(GL_FRAMEBUFFER, FBO[0]);
+				glClear(GL_COLOR_BUFFER_BIT);
+				glBindVertexArray(empty_VAO);
+
+				//ע룺ÿRSM texelһ㣬Ҳۼӵڵĸ
+				glEnable(GL_BLEND);
+				glBlendFunc(GL_ONE, GL_ONE);
+				inject_prog.set("light_pos", light_pos);
+				inject_prog.set("volume_min", box.min);
+				inject_prog.set("volume_cell", cell);
+				glDrawArrays(GL_POINTS, 0, rsm_face * rsm_face * 6);
+
+				//ÿδһȡдһ飬дͬʱۼӵۻ
+				for (int i = 0; i < propagation_num; ++i) {
+					int src = i & 1, dst = src ^ 1;
+					glBindFramebuffer(GL_FRAMEBUFFER, FBO[dst]);
+					for (int j = 0; j < 3; ++j) glDisablei(GL_BLEND, j);
+					bind_group(src, 5);
+					propagate_prog.apply();
+					glDrawArraysInstanced(GL_TRIANGLES, 0, 3, size);
+				}
+				glDisable(GL_BLEND);
+				glBindVertexArray(0);
+				glBindFramebuffer(GL_FRAMEBUFFER, 0);
+				glEnable(GL_DEPTH_TEST);
+				glEnable(GL_CULL_FACE);
+				dirty = false;
+			}
+			bind_group(2, unit);
+			return ret;
+		}
+	};
+
+}
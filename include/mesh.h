@@ -1,6 +1,7 @@
 #pragma once
 #include "texture.h"
 #include "shader.h"
+#include "bound.h"
 #include <vector>
 #include <string>
 
@@ -15,14 +16,17 @@ namespace illusion {
 	class Mesh {
 		Texture* diffuse, *specular;
 		unsigned VAO, VBO, EBO; //ÿmeshάһ׻
+		unsigned LBO; //ͼֻ꣬ں決ͼ󴴽
 		glm::mat4 model; //ÿmeshάһ任
 		unsigned indice_num; //㣨
+		AABB local_bound, bound; //ģͿռռİΧ
 
 		Mesh(const Mesh&) = default; //ֹ
 
 	public:
 		Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned>& indices, Texture* diffuse, Texture* specular, const glm::mat4& model)
-			:diffuse(diffuse), specular(specular), VAO(~0), VBO(~0), EBO(~0), model(model), indice_num(indices.size())
+			:diffuse(diffuse), specular(specular), VAO(~0), VBO(~0), EBO(~0), LBO(~0), model(model), indice_num(indices.size()),
+			local_bound(calc_bound(vertices, glm::mat4(1.0f))), bound(local_bound.transform(model))
 		{
 			//ǿ
 			if (indice_num) {
@@ -55,6 +59,7 @@ namespace illusion {
 			rhs.VAO = ~0;
 			rhs.VBO = ~0;
 			rhs.EBO = ~0;
+			rhs.LBO = ~0;
 		}
 
 		~Mesh() {
@@ -63,6 +68,34 @@ namespace illusion {
 				glDeleteBuffers(1, &VBO);
 				glDeleteBuffers(1, &EBO);
 			}
+			if (~LBO) glDeleteBuffers(1, &LBO);
+		}
+
+		//㶥任İΧ
+		static AABB calc_bound(const std::vector<Vertex>& vertices, const glm::mat4& model) {
+			AABB ret;
+			for (auto& v : vertices) ret.extend(v.position);
+			return ret.transform(model);
+		}
+
+		const AABB& get_bound() const { return bound; }
+		const glm::mat4& get_model() const { return model; }
+
+		void set_model(const glm::mat4& value) {
+			model = value;
+			bound = local_bound.transform(model);
+		}
+
+		//ÿĹͼ꣬Ϊ3
+		void set_lightmap_coords(const std::vector<glm::vec2>& coords) {
+			if (!indice_num) return;
+			if (!~LBO) glGenBuffers(1, &LBO);
+			glBindVertexArray(VAO);
+			glBindBuffer(GL_ARRAY_BUFFER, LBO);
+			glBufferData(GL_ARRAY_BUFFER, coords.size() * sizeof(glm::vec2), coords.data(), GL_STATIC_DRAW);
+			glEnableVertexAttribArray(3);
+			glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
+			glBindVertexArray(0);
 		}
 
 		//ʵʵĻƺ
@@ -0,0 +1,162 @@
+#pragma once
+#include "bound.h"
+#include "mesh.h"
+#include "parallel.h"
+#include <vector>
+
+namespace illusion {
+
+	//դڵ壺ڵ壨ǽȣͷֱʵȻ壬
+	//ÿtileԶȣHiZİΧ֮Ƚ޳ȫס
+	class OcclusionBuffer {
+		static constexpr int tile = 8; //HiZÿtileı߳
+		int width, height;
+		std::vector<float> depth; //[0, 1]ΧȣԽСԽ
+		std::vector<float> hiz; //ÿtileԶ
+		std::vector<glm::vec3> occluders; //ռڵΣÿ3һ
+		std::vector<glm::vec3> screen; //֡Ļռ
+		glm::mat4 view_projection;
+
+		//Ѳüռĵ任Ļռ
+		glm::vec3 to_screen(const glm::vec4& p) const {
+			glm::vec3 ndc = glm::vec3(p) / p.w;
+			return glm::vec3((ndc.x * 0.5f + 0.5f) * width, (ndc.y * 0.5f + 0.5f) * height, ndc.z * 0.5f + 0.5f);
+		}
+
+		//ýƽüһΣĻռεʽscreen
+		void clip(const glm::vec4* v) {
+			glm::vec4 out[4];
+			int n = 0;
+			for (int i = 0; i < 3; ++i) {
+				const glm::vec4& a = v[i], & b = v[(i + 1) % 3];
+				float da = a.z + a.w, db = b.z + b.w; //ƽ
+				if (da >= 0.0f) out[n++] = a;
+				if ((da >= 0.0f) != (db >= 0.0f)) out[n++] = a + (b - a) * (da / (da - db));
+			}
+			for (int i = 1; i + 1 < n; ++i) {
+				screen.push_back(to_screen(out[0]));
+				screen.push_back(to_screen(out[i]));
+				screen.push_back(to_screen(out[i + 1]));
+			}
+		}
+
+		//դ[y0, y1)ڵĲ֣ÿδһе4
+		void raster(int y0, int y1) {
+			const __m128 offset = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+			for (size_t t = 0; t < screen.size(); t += 3) {
+				glm::vec3 a = screen[t], b = screen[t + 1], c = screen[t + 2];
+				float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+				if (area == 0.0f) continue;
+				if (area < 0.0f) std::swap(b, c), area = -area;
+
+				int min_x = std::max(0, (int)std::floor(std::min({ a.x, b.x, c.x }))) & ~3;
+				int max_x = std::min(width - 1, (int)std::ceil(std::max({ a.x, b.x, c.x })));
+				int min_y = std::max(y0, (int)std::floor(std::min({ a.y, b.y, c.y })));
+				int max_y = std::min(y1 - 1, (int)std::ceil(std::max({ a.y, b.y, c.y })));
+				if (min_x > max_x || min_y > max_y) continue;
+
+				//ߺE(p) = A * x + B * y + CڲߺǸ
+				//ǰͬĶ˵˳ȡ֤ĽǡûΪ෴ڹ·϶
+				float ea[3], eb[3], ec[3];
+				const glm::vec3* v[3] = { &a, &b, &c };
+				for (int i = 0; i < 3; ++i) {
+					const glm::vec3* p = v[i], * q = v[(i + 1) % 3];
+					bool flip = p->x > q->x || (p->x == q->x && p->y > q->y);
+					if (flip) std::swap(p, q);
+					ea[i] = p->y - q->y;
+					eb[i] = q->x - p->x;
+					ec[i] = -(ea[i] * p->x + eb[i] * p->y);
+					if (flip) ea[i] = -ea[i], eb[i] = -eb[i], ec[i] = -ec[i];
+				}
+				//ĻռԺ
+				float dzdx = ((b.z - a.z) * (c.y - a.y) - (c.z - a.z) * (b.y - a.y)) / area;
+				float dzdy = ((c.z - a.z) * (b.x - a.x) - (b.z - a.z) * (c.x - a.x)) / area;
+				float z0 = a.z - dzdx * a.x - dzdy * a.y;
+
+				for (int y = min_y; y <= max_y; ++y) {
+					float py = y + 0.5f;
+					float* row = &depth[y * width];
+					for (int x = min_x; x <= max_x; x += 4) {
+						__m128 px = _mm_add_ps(_mm_set1_ps((float)x), offset);
+						__m128 mask = _mm_cmpeq_ps(px, px);
+						for (int i = 0; i < 3; ++i) {
+							__m128 e = _mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(ea[i])), _mm_set1_ps(eb[i] * py + ec[i]));
+							mask = _mm_and_ps(mask, _mm_cmpge_ps(e, _mm_setzero_ps()));
+						}
+						if (!_mm_movemask_ps(mask)) continue;
+						__m128 z = _mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(dzdx)), _mm_set1_ps(z0 + dzdy * py));
+						__m128 old = _mm_loadu_ps(row + x);
+						__m128 res = _mm_or_ps(_mm_and_ps(mask, _mm_min_ps(old, z)), _mm_andnot_ps(mask, old));
+						_mm_storeu_ps(row + x, res);
+					}
+				}
+			}
+		}
+
+		//[ty0, ty1)tileԶ
+		void build_hiz(int ty0, int ty1) {
+			int tw = width / tile;
+			for (int ty = ty0; ty < ty1; ++ty) {
+				for (int tx = 0; tx < tw; ++tx) {
+					float far_z = 0.0f;
+					for (int y = ty * tile; y < (ty + 1) * tile; ++y)
+						for (int x = tx * tile; x < (tx + 1) * tile; ++x) far_z = std::max(far_z, depth[y * width + x]);
+					hiz[ty * tw + tx] = far_z;
+				}
+			}
+		}
+
+	public:
+		//͸Ҫtileı
+		OcclusionBuffer(int width = 256, int height = 192) :width(width), height(height),
+			depth(width * height, 1.0f), hiz((width / tile) * (height / tile), 1.0f), view_projection(1.0f) {}
+
+		bool empty() const { return occluders.empty(); }
+
+		//ڵ壬ڵΪ̬
+		void add_occluder(const std::vector<Vertex>& vertices, const std::vector<unsigned>& indices, const glm::mat4& model) {
+			for (unsigned i : indices) occluders.push_back(glm::vec3(model * glm::vec4(vertices[i].position, 1.0f)));
+		}
+
+		//Եǰڵ岢HiZtileзָ߳
+		void render(const glm::mat4& vp) {
+			view_projection = vp;
+			screen.clear();
+			for (size_t i = 0; i < occluders.size(); i += 3) {
+				glm::vec4 v[3];
+				for (int j = 0; j < 3; ++j) v[j] = vp * glm::vec4(occluders[i + j], 1.0f);
+				clip(v);
+			}
+			std::fill(depth.begin(), depth.end(), 1.0f);
+			parallel_for(height / tile, [this](unsigned begin, unsigned end) {
+				raster(begin * tile, end * tile);
+				build_hiz(begin, end);
+			}, 4);
+		}
+
+		//ΧǷܿɼ
+		bool visible(const AABB& box) const {
+			glm::vec3 lo(FLT_MAX), hi(-FLT_MAX);
+			for (int i = 0; i < 8; ++i) {
+				glm::vec4 p = view_projection * glm::vec4(i & 1 ? box.max.x : box.min.x,
+														  i & 2 ? box.max.y : box.min.y,
+														  i & 4 ? box.max.z : box.min.z, 1.0f);
+				if (p.z < -p.w) return true; //ƽ
+				glm::vec3 s = to_screen(p);
+				lo = glm::min(lo, s);
+				hi = glm::max(hi, s);
+			}
+			int tw = width / tile;
+			lo = glm::max(lo, glm::vec3(0.0f));
+			hi = glm::min(hi, glm::vec3((float)width - 1.0f, (float)height - 1.0f, 1.0f));
+			if (lo.x > hi.x || lo.y > hi.y) return true;
+			int x0 = (int)lo.x / tile, x1 = (int)hi.x / tile;
+			int y0 = (int)lo.y / tile, y1 = (int)hi.y / tile;
+			for (int ty = y0; ty <= y1; ++ty)
+				for (int tx = x0; tx <= x1; ++tx)
+					if (lo.z <= hiz[ty * tw + tx]) return true;
+			return false;
+		}
+	};
+
+}
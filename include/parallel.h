@@ -0,0 +1,105 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+#include <algorithm>
+
+namespace illusion {
+
+	//פḶ́߳һʹʱʱ٣ÿεöͻ߳
+	//ͬһʱִֻһ񱻷ֳɶΣ̺߳ύ߳һȡ
+	class ThreadPool {
+		std::vector<std::thread> workers;
+		std::mutex mutex, submit;
+		std::condition_variable wake, done;
+		const std::function<void(unsigned, unsigned)>* job;
+		unsigned n, step, chunk_num, next, finished;
+		bool quit;
+
+		ThreadPool() :job(nullptr), n(0), step(0), chunk_num(0), next(0), finished(0), quit(false) {
+			unsigned num = std::max(1u, std::thread::hardware_concurrency()) - 1;
+			for (unsigned i = 0; i < num; ++i)
+				workers.emplace_back([this]() {
+					busy() = true;
+					std::unique_lock<std::mutex> lock(mutex);
+					while (true) {
+						wake.wait(lock, [this]() { return quit || next < chunk_num; });
+						if (quit) return;
+						work(lock);
+					}
+				});
+		}
+
+		//ȡִʣĶΣʱmutex
+		void work(std::unique_lock<std::mutex>& lock) {
+			while (next < chunk_num) {
+				unsigned begin = next++ * step, end = std::min(n, begin + step);
+				lock.unlock();
+				(*job)(begin, end);
+				lock.lock();
+				if (++finished == chunk_num) done.notify_all();
+			}
+		}
+
+	public:
+		ThreadPool(const ThreadPool&) = delete;
+		~ThreadPool() {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				quit = true;
+			}
+			wake.notify_all();
+			for (auto& t : workers) t.join();
+		}
+
+		static ThreadPool& instance() {
+			static ThreadPool pool;
+			return pool;
+		}
+
+		//ǰ߳Ƿִ̳߳е񣬴ʱٴεparallel_forֱӴִУ
+		static bool& busy() {
+			thread_local bool flag = false;
+			return flag;
+		}
+
+		unsigned thread_num() const { return workers.size() + 1; }
+
+		//[0, count)ֳÿsizeִfunc(begin, end)ȫɺ󷵻
+		void run(unsigned count, unsigned size, const std::function<void(unsigned, unsigned)>& func) {
+			std::lock_guard<std::mutex> serial(submit);
+			std::unique_lock<std::mutex> lock(mutex);
+			job = &func;
+			n = count;
+			step = size;
+			chunk_num = (count + size - 1) / size;
+			next = finished = 0;
+			wake.notify_all();
+			busy() = true;
+			work(lock);
+			busy() = false;
+			done.wait(lock, [this]() { return finished == chunk_num; });
+			job = nullptr;
+		}
+	};
+
+	//[0, n)ƽֳɶΣִ̳߳func(begin, end)ǰ߳Ҳ
+	//ÿ߳ٷֵgrain̫ʱֱڵǰִ߳
+	template<typename F>
+	void parallel_for(unsigned n, F&& func, unsigned grain = 1) {
+		if (ThreadPool::busy()) {
+			if (n) func(0u, n);
+			return;
+		}
+		ThreadPool& pool = ThreadPool::instance();
+		unsigned thread_num = std::min(pool.thread_num(), (n + grain - 1) / grain);
+		if (thread_num <= 1) {
+			if (n) func(0u, n);
+			return;
+		}
+		pool.run(n, (n + thread_num - 1) / thread_num, std::ref(func));
+	}
+
+}
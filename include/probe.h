@@ -0,0 +1,265 @@
+#pragma once
+#include "shader.h"
+#include "texture.h"
+#include "bound.h"
+#include "mesh.h"
+#include "light.h"
+#include <fstream>
+#include <vector>
+#include <chrono>
+#include <cstring>
+
+namespace illusion {
+
+	//決ķն̽룺ڸǳ3DϷ̽룬ÿ̽Ⱦһֱֻӹĵͷֱͼ
+	//ͶӰL1гɷնȣ33DRGBͨУɫʱԲһ
+	//決д뻺ļΡʡԴ񲻱ʱֱӶȡ
+	class IrradianceProbes {
+	public:
+		static constexpr int grid = 8; //ÿһά̽
+
+	private:
+		static constexpr int unit = 9; //3ϵ󶨵ʼԪ
+		static constexpr int face_size = 16; //̽ͼÿķֱ
+		static constexpr unsigned magic = 0x33425250; //ļıʶ"PRB3"
+
+		//ļͷ뵱ǰȫһʱʹû
+		struct Header {
+			unsigned magic;
+			int grid, face_size;
+			unsigned object_num;
+			unsigned hash; //κͷʵFNV-1aϣ
+			unsigned light_hash; //йԴFNV-1aϣ
+			glm::vec3 min, max, light_pos;
+		};
+
+		Program project_prog; //ͼͶӰгprogram
+		unsigned tex[3];
+		unsigned FBO, capture_FBO, capture_RBO, empty_VAO;
+		CubeTexture capture; //̽ͼ
+		std::string path; //ļ·
+		AABB box; //񸲸ǵķΧ̽λÿӵ
+		unsigned object_num;
+		unsigned hash; //Ĺϣƶı󻺴ʧЧ
+		unsigned light_hash; //決ʱʹõĹԴĹϣԴı󻺴ʧЧ
+		bool ready; //ϵǷ
+		bool use_cache; //Ƿȡ
+		float bake_ms; //һκ決ĺʱ룩
+
+		static unsigned fnv(unsigned hash, const void* data, size_t bytes) {
+			const unsigned char* p = (const unsigned char*)data;
+			for (size_t i = 0; i < bytes; ++i) hash = (hash ^ p[i]) * 16777619u;
+			return hash;
+		}
+
+		glm::vec3 probe_pos(int x, int y, int z) const {
+			return box.min + (glm::vec3(x, y, z) + 0.5f) * (box.max - box.min) / float(grid);
+		}
+
+		Header header(const glm::vec3& light_pos) const {
+			return Header{ magic, grid, face_size, object_num, hash, light_hash, box.min, box.max, light_pos };
+		}
+
+		bool load(const glm::vec3& light_pos) {
+			std::ifstream fin(path, std::ios::binary);
+			if (!fin) return false;
+			Header h, cur = header(light_pos);
+			fin.read((char*)&h, sizeof(h));
+			if (!fin || std::memcmp(&h, &cur, sizeof(h))) return false;
+			std::vector<glm::vec4> data(grid * grid * grid);
+			for (int i = 0; i < 3; ++i) {
+				fin.read((char*)data.data(), data.size() * sizeof(glm::vec4));
+				if (!fin) {
+					std::cerr << "ERROR::PROBE::CACHE_TRUNCATED  " << path << std::endl;
+					return false;
+				}
+				glActiveTexture(GL_TEXTURE15);
+				glBindTexture(GL_TEXTURE_3D, tex[i]);
+				glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, grid, grid, grid, GL_RGBA, GL_FLOAT, data.data());
+			}
+			return true;
+		}
+
+		void save(const glm::vec3& light_pos) const {
+			std::ofstream fout(path, std::ios::binary);
+			if (!fout) {
+				std::cerr << "ERROR::PROBE::CACHE_WRITING_FAILED  " << path << std::endl;
+				return;
+			}
+			Header h = header(light_pos);
+			fout.write((const char*)&h, sizeof(h));
+			std::vector<glm::vec4> data(grid * grid * grid);
+			for (int i = 0; i < 3; ++i) {
+				glActiveTexture(GL_TEXTURE15);
+				glBindTexture(GL_TEXTURE_3D, tex[i]);
+				glGetTexImage(GL_TEXTURE_3D, 0, GL_RGBA, GL_FLOAT, data.data());
+				fout.write((const char*)data.data(), data.size() * sizeof(glm::vec4));
+			}
+		}
+
+		//̽ȾͼͶӰdraw(prog)
+		template<typename F>
+		void bake(Program& prog, F&& draw) {
+			static const glm::vec3 dirs[6] = { {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1} };
+			static const glm::vec3 ups[6] = { {0, -1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}, {0, -1, 0}, {0, -1, 0} };
+			float spacing = (box.max.x - box.min.x) / grid;
+			prog.set("projection", glm::perspective(glm::radians(90.0f), 1.0f, spacing * 0.05f, glm::length(box.max - box.min)));
+			//決ʱֱֻӹ
+			prog.set("probe_intensity", 0.0f);
+			glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+			for (int z = 0; z < grid; ++z)
+				for (int y = 0; y < grid; ++y)
+					for (int x = 0; x < grid; ++x) {
+						glm::vec3 pos = probe_pos(x, y, z);
+						glBindFramebuffer(GL_FRAMEBUFFER, capture_FBO);
+						glViewport(0, 0, face_size, face_size);
+						prog.set("view_pos", pos);
+						for (int i = 0; i < 6; ++i) {
+							glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, capture.id(), 0);
+							glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+							prog.set("view", glm::lookAt(pos, pos + dirs[i], ups[i]));
+							draw(prog);
+						}
+						//z(x, y)
+						glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+						for (int i = 0; i < 3; ++i) glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, tex[i], 0, z);
+						glViewport(x, y, 1, 1);
+						glDisable(GL_DEPTH_TEST);
+						glActiveTexture(GL_TEXTURE15);
+						glBindTexture(GL_TEXTURE_CUBE_MAP, capture.id());
+						project_prog.apply();
+						glBindVertexArray(empty_VAO);
+						glDrawArrays(GL_TRIANGLES, 0, 3);
+						glBindVertexArray(0);
+						glEnable(GL_DEPTH_TEST);
+					}
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		}
+
+	public:
+		IrradianceProbes() :tex{ ~0u, ~0u, ~0u }, FBO(~0), capture_FBO(~0), capture_RBO(~0), empty_VAO(~0),
+			object_num(0), hash(2166136261u), light_hash(2166136261u), ready(false), use_cache(true), bake_ms(0.0f) {}
+		IrradianceProbes(const IrradianceProbes&) = delete;
+		~IrradianceProbes() {
+			for (auto f : { FBO, capture_FBO }) if (~f) glDeleteFramebuffers(1, &f);
+			if (~capture_RBO) glDeleteRenderbuffers(1, &capture_RBO);
+			for (auto t : tex) if (~t) glDeleteTextures(1, &t);
+			if (~empty_VAO) glDeleteVertexArrays(1, &empty_VAO);
+		}
+
+		bool init(const Program& target, const char* cache_path) {
+			Shader vs(GL_VERTEX_SHADER, "./shader/deferred.vs");
+			Shader fs(GL_FRAGMENT_SHADER, "./shader/probe_project.fs");
+			if (vs.fail() || fs.fail() || !project_prog.link(vs, fs)) return false;
+			path = cache_path;
+
+			glGenTextures(3, tex);
+			for (int i = 0; i < 3; ++i) {
+				glActiveTexture(GL_TEXTURE15);
+				glBindTexture(GL_TEXTURE_3D, tex[i]);
+				glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA16F, grid, grid, grid, 0, GL_RGBA, GL_FLOAT, NULL);
+				glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+				glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+				glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+				glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+				glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+			}
+			glGenFramebuffers(1, &FBO);
+			glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+			for (int i = 0; i < 3; ++i) glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, tex[i], 0, 0);
+			unsigned attachments[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+			glDrawBuffers(3, attachments);
+			if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+				std::cerr << "ERROR::FRAMEBUFFER::PROBE_INCOMPLETE" << std::endl;
+
+			capture = CubeTexture(GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST);
+			glActiveTexture(GL_TEXTURE15);
+			glBindTexture(GL_TEXTURE_CUBE_MAP, capture.id());
+			for (int i = 0; i < 6; ++i)
+				glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA16F, face_size, face_size, 0, GL_RGBA, GL_FLOAT, NULL);
+			glGenRenderbuffers(1, &capture_RBO);
+			glBindRenderbuffer(GL_RENDERBUFFER, capture_RBO);
+			glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, face_size, face_size);
+			glGenFramebuffers(1, &capture_FBO);
+			glBindFramebuffer(GL_FRAMEBUFFER, capture_FBO);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X, capture.id(), 0);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, capture_RBO);
+			if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+				std::cerr << "ERROR::FRAMEBUFFER::PROBE_CAPTURE_INCOMPLETE" << std::endl;
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			glGenVertexArrays(1, &empty_VAO);
+
+			project_prog.set("full_screen", 1);
+			project_prog.set("radiance_map", 15);
+			project_prog.set("face_size", face_size);
+			target.set("probe_r", unit);
+			target.set("probe_g", unit + 1);
+			target.set("probe_b", unit + 2);
+			target.set("probe_intensity", 0.0f);
+			return true;
+		}
+
+		//һ壬ռκͷʼ뻺Ĺϣ
+		void add(const std::vector<Vertex>& vertices, const std::vector<unsigned>& indices, const glm::mat4& model, const glm::vec3& albedo) {
+			for (unsigned i = 0; i + 2 < indices.size(); i += 3) {
+				glm::vec3 v[3];
+				for (int j = 0; j < 3; ++j) v[j] = glm::vec3(model * glm::vec4(vertices[indices[i + j]].position, 1.0f));
+				hash = fnv(hash, v, sizeof(v));
+			}
+			hash = fnv(hash, &albedo, sizeof(albedo));
+			++object_num;
+			ready = false;
+		}
+
+		//決ʱɫpassʹõȫԴֻжϻǷ
+		void set_lights(const std::vector<PointLight>& point, const std::vector<SpotLight>& spot, const std::vector<DirLight>& dir) {
+			light_hash = 2166136261u;
+			for (auto& l : point) light_hash = fnv(light_hash, &l, sizeof(l));
+			for (auto& l : spot) light_hash = fnv(light_hash, &l, sizeof(l));
+			for (auto& l : dir) light_hash = fnv(light_hash, &l, sizeof(l));
+		}
+
+		//񸲸ǳ
+		void set_bounds(const Program& target, const AABB& scene) {
+			if (scene.empty()) return;
+			box = scene;
+			target.set("probe_min", box.min);
+			target.set("probe_extent", box.max - box.min);
+			ready = false;
+		}
+
+		//һprepareʱԻº決
+		void rebake() {
+			ready = false;
+			use_cache = false;
+		}
+
+		//Ҫʱȡ決ϵ󶨵ɫpassʹõԪϣǷ決
+		//決޸progprojectionviewview_posҪָ
+		template<typename F>
+		bool prepare(Program& prog, const glm::vec3& light_pos, F&& draw) {
+			bool baked = false;
+			if (!ready && !box.empty()) {
+				if (!use_cache || !load(light_pos)) {
+					auto start = std::chrono::steady_clock::now();
+					bake(prog, draw);
+					glFinish();
+					bake_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+					save(light_pos);
+					baked = true;
+				}
+				prog.set("probe_intensity", 1.0f);
+				ready = true;
+				use_cache = true;
+			}
+			for (int i = 0; i < 3; ++i) {
+				glActiveTexture(GL_TEXTURE0 + unit + i);
+				glBindTexture(GL_TEXTURE_3D, tex[i]);
+			}
+			return baked;
+		}
+
+		float get_bake_ms() const { return bake_ms; }
+	};
+
+}
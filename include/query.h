@@ -0,0 +1,119 @@
+#pragma once
+#include "builder.h"
+#include "bound.h"
+#include <vector>
+
+namespace illusion {
+
+	//Ӳڵѯ޳һ֡ĲѯǷƣ
+	//һ֡סȻưΧнвѯȾ»ƣGPUǷ
+	class OcclusionQuery {
+		struct State {
+			unsigned query; //ѯ
+			bool pending; //ѯδȡ
+			bool visible; //һȡصĽ
+		};
+
+		std::vector<State> states;
+		Program prog; //ưΧеprogram
+		Mesh cube; //λ
+		unsigned frame;
+		unsigned interval; //ɼÿ֡²ѯһ
+
+		static Mesh build_cube() {
+			CubeBuilder builder(glm::vec3(0.0f), 1.0f);
+			builder.build();
+			return Mesh(builder.vertices, builder.indices, nullptr, nullptr, glm::mat4(1.0f));
+		}
+
+		//ΧжӦı任΢Ŵͬ
+		static glm::mat4 box_model(const AABB& box) {
+			glm::vec3 size = glm::max(box.max - box.min, glm::vec3(1e-3f)) * 1.01f;
+			return glm::scale(glm::translate(glm::mat4(1.0f), box.center()), size);
+		}
+
+	public:
+		OcclusionQuery() :cube(build_cube()), frame(0), interval(4) {}
+		OcclusionQuery(const OcclusionQuery&) = delete;
+		~OcclusionQuery() { for (auto& s : states) glDeleteQueries(1, &s.query); }
+
+		bool init() {
+			Shader vs(GL_VERTEX_SHADER, "./shader/bound.vs");
+			Shader fs(GL_FRAGMENT_SHADER, "./shader/bound.fs");
+			return !vs.fail() && !fs.fail() && prog.link(vs, fs);
+		}
+
+		void set_interval(unsigned value) { interval = value ? value : 1; }
+
+		//ʼµһ֡ȡѾɵĲѯȴGPU
+		void begin_frame(unsigned object_num) {
+			++frame;
+			while (states.size() < object_num) {
+				State s{ 0, false, true };
+				glGenQueries(1, &s.query);
+				states.push_back(s);
+			}
+			for (auto& s : states) {
+				if (!s.pending) continue;
+				unsigned available = 0;
+				glGetQueryObjectuiv(s.query, GL_QUERY_RESULT_AVAILABLE, &available);
+				if (!available) continue;
+				unsigned result = 0;
+				glGetQueryObjectuiv(s.query, GL_QUERY_RESULT, &result);
+				s.visible = result != 0;
+				s.pending = false;
+			}
+		}
+
+		//һ֡Ľ壬visibleбֱӻƵ壬hiddenҪѯƵ
+		void classify(std::vector<unsigned>& visible, std::vector<unsigned>& hidden, const BoundSet& bounds, const glm::vec3& eye) {
+			hidden.clear();
+			unsigned n = 0;
+			for (unsigned id : visible) {
+				AABB box = bounds.get(id);
+				bool inside = glm::all(glm::greaterThanEqual(eye, box.min - 0.1f)) && glm::all(glm::lessThanEqual(eye, box.max + 0.1f));
+				if (states[id].visible || inside) visible[n++] = id;
+				else hidden.push_back(id);
+			}
+			visible.resize(n);
+		}
+
+		//ɼǷҪڱ֡²ѯѯ⼯ͬһ֡
+		bool due(unsigned id) const {
+			return !states[id].pending && (frame + id) % interval == 0;
+		}
+
+		//屾ĻΪѯ
+		void begin(unsigned id) { glBeginQuery(GL_ANY_SAMPLES_PASSED, states[id].query); }
+		void end(unsigned id) {
+			glEndQuery(GL_ANY_SAMPLES_PASSED);
+			states[id].pending = true;
+		}
+
+		//ΪhiddenеưΧнвѯдɫ
+		//һεĲѯδȡʱ²ѯⶪеĽֱʹβѯ
+		void query_boxes(const std::vector<unsigned>& hidden, const BoundSet& bounds, const glm::mat4& view, const glm::mat4& projection) {
+			if (hidden.empty()) return;
+			prog.set("view", view);
+			prog.set("projection", projection);
+			glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+			glDepthMask(GL_FALSE);
+			glDisable(GL_CULL_FACE);
+			for (unsigned id : hidden) {
+				if (states[id].pending) continue;
+				cube.set_model(box_model(bounds.get(id)));
+				begin(id);
+				cube.draw(prog);
+				end(id);
+			}
+			glEnable(GL_CULL_FACE);
+			glDepthMask(GL_TRUE);
+			glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		}
+
+		//idĲѯ½л
+		void begin_conditional(unsigned id) { glBeginConditionalRender(states[id].query, GL_QUERY_WAIT); }
+		void end_conditional() { glEndConditionalRender(); }
+	};
+
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include "shader.h"
+#include "texture.h"
+#include <vector>
+#include <random>
+
+namespace illusion {
+
+	//RSMģʽCPUԤԲڵĲ㣬ϴuniform bufferУ
+	//ÿеĽǶתײ
+	class SamplePattern {
+	public:
+		static constexpr unsigned max_sample_num = 128; //ҪɫеMAX_SAMPLE_NUMһ
+		static constexpr int noise_size = 4;
+
+	private:
+		static constexpr unsigned binding = 0; //uniform bufferİ󶨵
+		static constexpr int unit = 8; //󶨵Ԫ
+
+		unsigned UBO;
+		Texture noise;
+
+		//best-candidateɽĲԲ̷ֲǰ׺ֲ
+		//㰴RSMȡ(xi1 * sin(2 pi xi2), xi1 * cos(2 pi xi2))ԽԽܼȨΪxi1^2
+		static std::vector<glm::vec4> generate(unsigned num) {
+			std::mt19937 rng(5489u);
+			std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+			std::vector<glm::vec4> ret;
+			for (unsigned i = 0; i < num; ++i) {
+				glm::vec4 best(0.0f);
+				float best_dist = -1.0f;
+				unsigned candidate_num = i + 1; //ѡв
+				for (unsigned c = 0; c < candidate_num; ++c) {
+					float xi1 = dist(rng), xi2 = dist(rng);
+					float angle = 2.0f * glm::pi<float>() * xi2;
+					glm::vec2 p(xi1 * std::sin(angle), xi1 * std::cos(angle));
+					float nearest = FLT_MAX;
+					for (auto& s : ret) nearest = std::min(nearest, glm::length(glm::vec2(s) - p));
+					//ܶȷŴ󿿽ĵľ룬ĸ̫ӵ
+					nearest /= std::max(xi1, 0.05f);
+					if (nearest > best_dist) best_dist = nearest, best = glm::vec4(p, xi1 * xi1, 0.0f);
+				}
+				ret.push_back(best);
+			}
+			return ret;
+		}
+
+	public:
+		SamplePattern() :UBO(~0) {}
+		SamplePattern(const SamplePattern&) = delete;
+		~SamplePattern() { if (~UBO) glDeleteBuffers(1, &UBO); }
+
+		void init() {
+			std::vector<glm::vec4> samples = generate(max_sample_num);
+			glGenBuffers(1, &UBO);
+			glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+			glBufferData(GL_UNIFORM_BUFFER, samples.size() * sizeof(glm::vec4), samples.data(), GL_STATIC_DRAW);
+			glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+			//бתǵҺ
+			std::mt19937 rng(1234u);
+			std::uniform_real_distribution<float> dist(0.0f, 2.0f * glm::pi<float>());
+			unsigned char data[noise_size * noise_size * 2];
+			for (int i = 0; i < noise_size * noise_size; ++i) {
+				float angle = dist(rng);
+				data[i * 2] = (unsigned char)((std::cos(angle) * 0.5f + 0.5f) * 255.0f + 0.5f);
+				data[i * 2 + 1] = (unsigned char)((std::sin(angle) * 0.5f + 0.5f) * 255.0f + 0.5f);
+			}
+			noise = Texture(GL_REPEAT, GL_NEAREST, GL_NEAREST);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RG8, noise_size, noise_size, 0, GL_RG, GL_UNSIGNED_BYTE, data);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		}
+
+		//Ѳprog
+		void attach(const Program& prog) const {
+			unsigned index = glGetUniformBlockIndex(prog.id(), "RsmSamples");
+			if (index == GL_INVALID_INDEX) {
+				std::cerr << "ERROR::PROGRAM::INVALID_BLOCK RsmSamples" << std::endl;
+				return;
+			}
+			glUniformBlockBinding(prog.id(), index, binding);
+			prog.set("noise_map", unit);
+		}
+
+		void bind() const {
+			glBindBufferBase(GL_UNIFORM_BUFFER, binding, UBO);
+			noise.bind(unit);
+		}
+	};
+
+}
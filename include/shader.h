@@ -103,10 +103,18 @@ namespace illusion {
 			apply();
 			glUniform1f(get_uniform_location(name), value);
 		}
+		inline void set(const char* name, const glm::vec2& value) const {
+			apply();
+			glUniform2fv(get_uniform_location(name), 1, glm::value_ptr(value));
+		}
 		inline void set(const char* name, const glm::vec3& value) const {
 			apply();
 			glUniform3fv(get_uniform_location(name), 1, glm::value_ptr(value));
 		}
+		inline void set(const char* name, const glm::vec4& value) const {
+			apply();
+			glUniform4fv(get_uniform_location(name), 1, glm::value_ptr(value));
+		}
 		inline void set(const char* name, const glm::mat4& value) const {
 			apply();
 			glUniformMatrix4fv(get_uniform_location(name), 1, GL_FALSE, glm::value_ptr(value));
@@ -0,0 +1,255 @@
+#pragma once
+#include "shader.h"
+#include "texture.h"
+#include "light.h"
+#include "bound.h"
+#include "timer.h"
+#include <vector>
+
+namespace illusion {
+
+	//ԴӰĻƷʽ
+	enum class ShadowTechnique {
+		CUBE, //6
+		PARABOLOID //˫2򣬻ƿԼΪ1/3Ƚϵ
+	};
+
+	//ԴӰͼйԴӰչΪ3x2棬ͬһ2D
+	//ÿԴķֱʸĻϵӰ췶Χÿ֡GPUʱԤҪ»ƵĹԴ
+	class ShadowAtlas {
+	public:
+		static constexpr unsigned max_light_num = 4; //Ҫobject_shadow.fsеMAX_SHADOW_NUMһ
+		static constexpr int max_size = 512, min_size = 64; //ÿСֱ
+
+	private:
+		static constexpr int unit = 14; //ͼ󶨵Ԫ
+		static constexpr float near_plane = 0.1f; //ÿ͸ͶӰĽƽ
+		static constexpr float polygon_factor = 1.5f, polygon_units = 4.0f; //ӰʱglPolygonOffset
+		static constexpr int slot_width = max_size * 3, slot_height = max_size * 2; //ÿԴռõ
+		static constexpr int atlas_width = slot_width * 2, atlas_height = slot_height * 2;
+
+		struct Light {
+			glm::vec3 pos;
+			float range; //ͶӰķΧ
+			int size; //ÿķֱ
+			int rendered; //ͼѻƵķֱʣδʱΪ0
+			bool dirty; //Ҫ»
+			ShadowTechnique technique;
+		};
+
+		Texture atlas;
+		unsigned FBO;
+		Program paraboloid_prog; //˫Ӱprogram
+		float far_plane;
+		std::vector<Light> lights;
+		std::vector<unsigned> chosen; //֡µĹԴ
+		unsigned cursor; //µʼԴ
+		float budget_ms; //ÿ֡ӰƵGPUʱԤ
+		GpuTimer timers[2]; //ֻƷʽֱʱ
+		unsigned timed_num[2]; //ÿַʽһμʱиµĹԴ
+		unsigned timed_faces[2]; //ÿַʽһμʱлƵ
+		float light_ms[2]; //ÿַʽһԴƽʱ
+		float face_ms; //һƽʱڰԤ㻻Ϊ
+		unsigned updated_num, draw_num; //һ֡µĹԴƵ
+
+		//ԴĻϵӰ뾶أ׶岻ཻʱΪ0
+		static float influence(const Light& light, const glm::mat4& view, const glm::mat4& projection, int screen_height) {
+			if (!Frustum(projection * view).intersect(AABB(light.pos - light.range, light.pos + light.range))) return 0.0f;
+			float dist = glm::length(glm::vec3(view * glm::vec4(light.pos, 1.0f)));
+			if (dist <= light.range) return float(screen_height);
+			return light.range / dist * projection[1][1] * screen_height * 0.5f;
+		}
+
+		//ԴÿθҪƵ
+		static unsigned faces_of(ShadowTechnique technique) {
+			return technique == ShadowTechnique::CUBE ? 6 : 2;
+		}
+
+		static int size_of(float pixels) {
+			int size = min_size;
+			while (size < max_size && size < pixels) size <<= 1;
+			return size;
+		}
+
+		static glm::mat4 face_matrix(const glm::vec3& pos, int face, float far_plane) {
+			return glm::perspective(glm::radians(90.0f), 1.0f, near_plane, far_plane) * face_view(pos, face);
+		}
+
+		static glm::mat4 face_view(const glm::vec3& pos, int face) {
+			static const glm::vec3 dirs[6] = { {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1} };
+			static const glm::vec3 ups[6] = { {0, -1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}, {0, -1, 0}, {0, -1, 0} };
+			return glm::lookAt(pos, pos + dirs[face], ups[face]);
+		}
+
+		//ƹԴһ棬xyΪͼеλãcullΪ޳õľ
+		template<typename F>
+		void draw_face(Program& prog, const glm::mat4& cull, int x, int y, int size, F& draw) {
+			glViewport(x, y, size, size);
+			glScissor(x, y, size, size);
+			glClear(GL_DEPTH_BUFFER_BIT);
+			draw_num += draw(prog, cull);
+		}
+
+		//Ʊ֡ѡеġʹͬһַʽĹԴ
+		template<typename F>
+		void draw_lights(Program& prog, const Program& target, ShadowTechnique technique, F& draw) {
+			int t = (int)technique;
+			unsigned num = 0;
+			for (unsigned id : chosen) num += lights[id].technique == technique;
+			if (!num) return;
+			timers[t].begin();
+			if (timed_num[t]) {
+				float ms = timers[t].ms() / timed_num[t];
+				light_ms[t] = light_ms[t] == 0.0f ? ms : light_ms[t] * 0.9f + ms * 0.1f;
+				ms = timers[t].ms() / timed_faces[t];
+				face_ms = face_ms == 0.0f ? ms : face_ms * 0.9f + ms * 0.1f;
+			}
+			Program& p = technique == ShadowTechnique::CUBE ? prog : paraboloid_prog;
+			if (technique == ShadowTechnique::PARABOLOID) glEnable(GL_CLIP_DISTANCE0);
+			for (unsigned id : chosen) {
+				Light& light = lights[id];
+				if (light.technique != technique) continue;
+				int x = id % 2 * slot_width, y = id / 2 * slot_height;
+				if (technique == ShadowTechnique::CUBE) {
+					for (int face = 0; face < 6; ++face) {
+						glm::mat4 m = face_matrix(light.pos, face, far_plane);
+						p.set("face_matrix", m);
+						draw_face(p, m, x + face % 3 * light.size, y + face / 3 * light.size, light.size, draw);
+					}
+				} else {
+					//ġz泯ͬøǰͶӰ޳
+					glm::mat4 hemisphere = glm::ortho(-light.range, light.range, -light.range, light.range, 0.0f, light.range);
+					for (int k = 0; k < 2; ++k) {
+						glm::mat4 v = face_view(light.pos, 4 + k);
+						p.set("paraboloid_view", v);
+						draw_face(p, hemisphere * v, x + k * light.size, y, light.size, draw);
+					}
+				}
+				light.rendered = light.size;
+				light.dirty = false;
+				upload_tile(target, id);
+			}
+			if (technique == ShadowTechnique::PARABOLOID) glDisable(GL_CLIP_DISTANCE0);
+			timers[t].end();
+			timed_num[t] = num;
+			timed_faces[t] = num * faces_of(technique);
+		}
+
+		//Դ3x2ͼеλãɫоݴ˼
+		void upload_tile(const Program& prog, unsigned id) const {
+			const Light& light = lights[id];
+			glm::vec4 tile(float(id % 2 * slot_width), float(id / 2 * slot_height), float(light.rendered),
+						   light.technique == ShadowTechnique::PARABOLOID ? 1.0f : 0.0f);
+			std::string name = "shadow_tiles[" + std::to_string(id) + "]";
+			prog.set(name.c_str(), tile);
+		}
+
+	public:
+		ShadowAtlas() :FBO(~0), far_plane(25.0f), cursor(0), budget_ms(1.0f), timed_num{}, timed_faces{}, light_ms{}, face_ms(0.0f), updated_num(0), draw_num(0) {}
+		ShadowAtlas(const ShadowAtlas&) = delete;
+		~ShadowAtlas() { if (~FBO) glDeleteFramebuffers(1, &FBO); }
+
+		bool init(const Program& prog, float far_plane) {
+			Shader vs(GL_VERTEX_SHADER, "./shader/paraboloid.vs");
+			Shader fs(GL_FRAGMENT_SHADER, "./shader/shadow.fs");
+			if (vs.fail() || fs.fail() || !paraboloid_prog.link(vs, fs)) return false;
+			paraboloid_prog.set("far_plane", far_plane);
+			this->far_plane = far_plane;
+			//ȱȽϣɫsampler2DShadowԹ˵õӲPCF
+			atlas = Texture(GL_CLAMP_TO_EDGE, GL_LINEAR, GL_LINEAR);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, atlas_width, atlas_height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+			glGenFramebuffers(1, &FBO);
+			glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+			glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, atlas.id(), 0);
+			glDrawBuffer(GL_NONE);
+			glReadBuffer(GL_NONE);
+			if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+				std::cerr << "ERROR::FRAMEBUFFER::SHADOW_ATLAS_INCOMPLETE" << std::endl;
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			prog.set("shadow_atlas", unit);
+			prog.set("atlas_size", glm::vec2(atlas_width, atlas_height));
+			prog.set("shadow_near", near_plane);
+			prog.set("shadow_num", 0);
+			return true;
+		}
+
+		//ͶӰĵԴpoint_lightsе±ͬ
+		bool add_light(const Program& prog, const PointLight& light, ShadowTechnique technique = ShadowTechnique::CUBE) {
+			if (lights.size() >= max_light_num) return false;
+			lights.push_back({ light.pos, std::min(light.range(), far_plane), min_size, 0, true, technique });
+			upload_tile(prog, lights.size() - 1);
+			prog.set("shadow_num", (int)lights.size());
+			return true;
+		}
+
+		void set_technique(unsigned id, ShadowTechnique technique) {
+			if (id >= lights.size() || lights[id].technique == technique) return;
+			lights[id].technique = technique;
+			lights[id].dirty = true;
+		}
+
+		void move_light(unsigned id, const glm::vec3& pos) {
+			if (id >= lights.size()) return;
+			lights[id].pos = pos;
+			lights[id].dirty = true;
+		}
+
+		//Χڵ巢˱仯»ƷΧཻ֮ĹԴ
+		void invalidate(const AABB& box) {
+			for (auto& light : lights) {
+				glm::vec3 d = glm::max(glm::max(box.min - light.pos, light.pos - box.max), glm::vec3(0.0f));
+				if (glm::dot(d, d) <= light.range * light.range) light.dirty = true;
+			}
+		}
+
+		void set_budget(float ms) { budget_ms = ms; }
+		unsigned light_num() const { return lights.size(); }
+		unsigned get_updated_num() const { return updated_num; }
+		unsigned get_draw_num() const { return draw_num; }
+		float get_ms() const { return timers[0].average_ms() + timers[1].average_ms(); }
+		//ÿַʽһԴƽGPUʱڱȽַʽĿ
+		float get_light_ms(ShadowTechnique technique) const { return light_ms[(int)technique]; }
+
+		//·ֱʲԤڸ¹Դdraw(prog, face_matrix)һڵ岢
+		//progΪӰprogramtargetΪɫpassprogram
+		template<typename F>
+		void update(Program& prog, const Program& target, const glm::mat4& view, const glm::mat4& projection, int screen_height, F&& draw) {
+			for (auto& light : lights) {
+				light.size = size_of(influence(light, view, projection, screen_height));
+				if (light.size != light.rendered) light.dirty = true;
+			}
+
+			//֮ǰõÿĺʱԤ㻻Ϊѡ֡µĹԴٸһ
+			//δúʱʱҪ»ƵĹԴ
+			chosen.clear();
+			unsigned face_budget = face_ms > 0.0f ? unsigned(std::min(budget_ms / face_ms, 1e6f)) : ~0u, faces = 0;
+			unsigned num = lights.size(), next = cursor;
+			for (unsigned k = 0; k < num; ++k) {
+				unsigned id = (cursor + k) % num;
+				if (!lights[id].dirty) continue;
+				unsigned cost = faces_of(lights[id].technique);
+				if (!chosen.empty() && faces + cost > face_budget) break;
+				chosen.push_back(id);
+				faces += cost;
+				next = id + 1;
+			}
+			cursor = next % std::max(num, 1u);
+			updated_num = chosen.size();
+			draw_num = 0;
+
+			glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+			glEnable(GL_SCISSOR_TEST);
+			glEnable(GL_POLYGON_OFFSET_FILL); //бƫȣӰ
+			glPolygonOffset(polygon_factor, polygon_units);
+			draw_lights(prog, target, ShadowTechnique::CUBE, draw);
+			draw_lights(prog, target, ShadowTechnique::PARABOLOID, draw);
+			glDisable(GL_POLYGON_OFFSET_FILL);
+			glDisable(GL_SCISSOR_TEST);
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			atlas.bind(unit);
+		}
+	};
+
+}
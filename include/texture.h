@@ -35,6 +35,7 @@ namespace illusion {
 		Texture() :uid(~0), valid(false) {}
 		Texture(Texture&& rhs) noexcept :Texture(rhs) { rhs.valid = false; }
 		Texture& operator=(Texture&& rhs) noexcept {
+			if (valid && uid != rhs.uid) glDeleteTextures(1, &uid);
 			uid = rhs.uid;
 			valid = rhs.valid;
 			rhs.uid = ~0;
@@ -61,6 +62,26 @@ namespace illusion {
 			return false;
 		}
 
+		//ȡСmipmap㼶õƽɫҪѾmipmap
+		glm::vec3 average_color() const {
+			glActiveTexture(GL_TEXTURE15);
+			glBindTexture(GL_TEXTURE_2D, uid);
+			int width = 0, height = 0, level = 0;
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+			if (!width || !height) return glm::vec3(1.0f);
+			while ((width >> level) > 1 || (height >> level) > 1) ++level;
+			glm::vec3 color;
+			glGetTexImage(GL_TEXTURE_2D, level, GL_RGB, GL_FLOAT, &color);
+			return color;
+		}
+
+		//ָʽĿհ״洢ȾĿ
+		void storage(GLint format, int width, int height, GLenum type) const {
+			glActiveTexture(GL_TEXTURE15);
+			glBindTexture(GL_TEXTURE_2D, uid);
+			glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, GL_RGBA, type, NULL);
+		}
 		//󶨸texture
 		inline void bind(unsigned index) const { 
 			if (index >= 15) std::cerr << "ERROR::TEXTURE::INVALID_BIND_INDEX" << std::endl;
@@ -113,6 +134,31 @@ namespace illusion {
 	};
 
 
+	//õһԶд֡壬һʹʱ֮һֱ
+	//ÿθƽţ¶
+	inline const unsigned* copy_framebuffers() {
+		static unsigned fbo[2] = { ~0u, ~0u };
+		if (!~fbo[0]) glGenFramebuffers(2, fbo);
+		return fbo;
+	}
+
+	//渴ͼһŵ㣬maskΪGL_COLOR_BUFFER_BITGL_DEPTH_BUFFER_BIT
+	inline void copy_cube(unsigned src, unsigned dst, GLenum attachment, GLbitfield mask, int width, int height) {
+		const unsigned* fbo = copy_framebuffers();
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo[0]);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo[1]);
+		glReadBuffer(mask == GL_COLOR_BUFFER_BIT ? attachment : GL_NONE);
+		glDrawBuffer(mask == GL_COLOR_BUFFER_BIT ? attachment : GL_NONE);
+		for (int i = 0; i < 6; ++i) {
+			glFramebufferTexture2D(GL_READ_FRAMEBUFFER, attachment, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, src, 0);
+			glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, attachment, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, dst, 0);
+			glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, mask, GL_NEAREST);
+		}
+		glFramebufferTexture2D(GL_READ_FRAMEBUFFER, attachment, GL_TEXTURE_2D, 0, 0);
+		glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, attachment, GL_TEXTURE_2D, 0, 0);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
 	class FrameBuffer {
 		CubeTexture tex;
 		unsigned FBO;
@@ -141,66 +187,339 @@ namespace illusion {
 		}
 		~FrameBuffer() { if (~FBO) glDeleteFramebuffers(1, &FBO); }
 		void use(int id) { glBindFramebuffer(GL_FRAMEBUFFER, FBO); tex.bind(id); }
+		//֡岢ֻͼһ棬ʱҪɫ
+		void use_face(int face) {
+			glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, tex.id(), 0);
+		}
+		//ֻtextureı䵱ǰ֡
+		void bind(int id) const { tex.bind(id); }
+		//һͼ
+		void copy_from(const FrameBuffer& src, int width, int height) {
+			copy_cube(src.tex.id(), tex.id(), GL_DEPTH_ATTACHMENT, GL_DEPTH_BUFFER_BIT, width, height);
+		}
 	};
 
+	//RSM֡壺geometryķ͵Դľ루RGBA16Fλɾؽ
+	//flux淴ķͨR11F_G11F_B10Fÿֻȡ
+	//߶mipmapյԽԶĲȡԽֲڵĲ㼶
 	class FullFrameBuffer {
-		CubeTexture normal, depth, color, pos;
+		CubeTexture geometry, flux, depth;
 		unsigned FBO;
 	public:
 		FullFrameBuffer() :FBO(~0) {}
 		FullFrameBuffer(FullFrameBuffer&& rhs) noexcept :
-			normal(std::move(rhs.normal)),
+			geometry(std::move(rhs.geometry)),
+			flux(std::move(rhs.flux)),
 			depth(std::move(rhs.depth)),
-			color(std::move(rhs.color)),
-			pos(std::move(rhs.pos)),
 			FBO(rhs.FBO)
 		{
 			rhs.FBO = ~0;
 		}
 		FullFrameBuffer(int width, int height) :
-			normal(GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST),
-			depth(GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST),
-			color(GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST),
-			pos(GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST),
+			geometry(GL_CLAMP_TO_EDGE, GL_NEAREST_MIPMAP_NEAREST, GL_NEAREST),
+			flux(GL_CLAMP_TO_EDGE, GL_LINEAR_MIPMAP_NEAREST, GL_LINEAR),
+			depth(GL_CLAMP_TO_EDGE, GL_LINEAR, GL_LINEAR),
 			FBO(~0)
 		{
+			//ȿȽϣɫsamplerCubeShadow
 			depth.bind(0);
 			for (int i = 0; i < 6; ++i)
-				glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-			normal.bind(0);
-			for (int i = 0; i < 6; ++i)
-				glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB, GL_FLOAT, NULL);
-			pos.bind(0);
+				glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT24, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+			geometry.bind(0);
 			for (int i = 0; i < 6; ++i)
-				glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB, GL_FLOAT, NULL);
-			color.bind(0);
+				glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
+			flux.bind(0);
 			for (int i = 0; i < 6; ++i)
-				glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+				glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_R11F_G11F_B10F, width, height, 0, GL_RGB, GL_FLOAT, NULL);
 
 			glGenFramebuffers(1, &FBO);
 			glBindFramebuffer(GL_FRAMEBUFFER, FBO);
-			glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, pos.id(), 0);
-			glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, normal.id(), 0);
-			glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, color.id(), 0);
+			glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, geometry.id(), 0);
+			glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, flux.id(), 0);
 			glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depth.id(), 0);
-			unsigned attachments[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
-			glDrawBuffers(3, attachments);
+			unsigned attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+			glDrawBuffers(2, attachments);
 			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			generate_mipmap();
 		}
 		FullFrameBuffer& operator=(FullFrameBuffer&& rhs) noexcept {
 			if (~FBO) glDeleteFramebuffers(1, &FBO);
-			normal = std::move(rhs.normal);
-			color = std::move(rhs.color);
-			pos = std::move(rhs.pos);
+			geometry = std::move(rhs.geometry);
+			flux = std::move(rhs.flux);
 			depth = std::move(rhs.depth);
 			FBO = rhs.FBO;
 			rhs.FBO = ~0;
 			return *this;
 		}
 		~FullFrameBuffer() { if (~FBO) glDeleteFramebuffers(1, &FBO); }
-		void use(int id_pos_normal_color_depth) {
-			int id = id_pos_normal_color_depth;
-			glBindFramebuffer(GL_FRAMEBUFFER, FBO); pos.bind(id); normal.bind(id + 1); color.bind(id + 2); depth.bind(id + 3);
+		void use(int id_geometry_flux_depth) {
+			glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+			bind(id_geometry_flux_depth);
+		}
+		//֡岢ֻÿͼһ
+		void use_face(int face) {
+			GLenum target = GL_TEXTURE_CUBE_MAP_POSITIVE_X + face;
+			glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, target, geometry.id(), 0);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, target, flux.id(), 0);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, target, depth.id(), 0);
+		}
+		//ֻtextureı䵱ǰ֡
+		void bind(int id_geometry_flux_depth) const {
+			int id = id_geometry_flux_depth;
+			geometry.bind(id); flux.bind(id + 1); depth.bind(id + 2);
+		}
+		//ɺɵ0geometryfluxmipmap
+		void generate_mipmap() const {
+			glActiveTexture(GL_TEXTURE15);
+			glBindTexture(GL_TEXTURE_CUBE_MAP, geometry.id());
+			glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+			glBindTexture(GL_TEXTURE_CUBE_MAP, flux.id());
+			glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+		}
+		//ѵlevel㣨ֱΪsizeǰ󶨵GL_PIXEL_PACK_BUFFERУ
+		//6geometryRGBA floatǰfluxRGB floatflux_offsetʼ
+		void read(int level, int size, size_t flux_offset) const {
+			size_t face = size_t(size) * size * sizeof(float);
+			glActiveTexture(GL_TEXTURE15);
+			glBindTexture(GL_TEXTURE_CUBE_MAP, geometry.id());
+			for (int i = 0; i < 6; ++i)
+				glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, level, GL_RGBA, GL_FLOAT, (void*)(face * 4 * i));
+			glBindTexture(GL_TEXTURE_CUBE_MAP, flux.id());
+			for (int i = 0; i < 6; ++i)
+				glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, level, GL_RGB, GL_FLOAT, (void*)(flux_offset + face * 3 * i));
+		}
+		//һRSMͼĵ0
+		void copy_from(const FullFrameBuffer& src, int width, int height) {
+			copy_cube(src.geometry.id(), geometry.id(), GL_COLOR_ATTACHMENT0, GL_COLOR_BUFFER_BIT, width, height);
+			copy_cube(src.flux.id(), flux.id(), GL_COLOR_ATTACHMENT0, GL_COLOR_BUFFER_BIT, width, height);
+			copy_cube(src.depth.id(), depth.id(), GL_DEPTH_ATTACHMENT, GL_DEPTH_BUFFER_BIT, width, height);
+		}
+	};
+
+	//۹ƺƽй2D RSMʽFullFrameBufferֻͬgeometryzԴ۲ռ
+	//ӿFullFrameBufferһ£Թþ̬Ͷ̬Ļ߼
+	class FlatFrameBuffer {
+		Texture geometry, flux, depth;
+		unsigned FBO;
+	public:
+		FlatFrameBuffer() :FBO(~0) {}
+		FlatFrameBuffer(FlatFrameBuffer&& rhs) noexcept :
+			geometry(std::move(rhs.geometry)),
+			flux(std::move(rhs.flux)),
+			depth(std::move(rhs.depth)),
+			FBO(rhs.FBO)
+		{
+			rhs.FBO = ~0;
+		}
+		FlatFrameBuffer(int width, int height) :
+			geometry(GL_CLAMP_TO_EDGE, GL_NEAREST_MIPMAP_NEAREST, GL_NEAREST),
+			flux(GL_CLAMP_TO_EDGE, GL_LINEAR_MIPMAP_NEAREST, GL_LINEAR),
+			depth(GL_CLAMP_TO_BORDER, GL_LINEAR, GL_LINEAR),
+			FBO(~0)
+		{
+			//ȿȽϣɫsampler2DShadowΧⰴӰд
+			float border[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+			depth.bind(0);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+			glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border);
+			geometry.bind(0);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
+			flux.bind(0);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_R11F_G11F_B10F, width, height, 0, GL_RGB, GL_FLOAT, NULL);
+
+			glGenFramebuffers(1, &FBO);
+			glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, geometry.id(), 0);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, flux.id(), 0);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth.id(), 0);
+			unsigned attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+			glDrawBuffers(2, attachments);
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			generate_mipmap();
+		}
+		FlatFrameBuffer& operator=(FlatFrameBuffer&& rhs) noexcept {
+			if (~FBO) glDeleteFramebuffers(1, &FBO);
+			geometry = std::move(rhs.geometry);
+			flux = std::move(rhs.flux);
+			depth = std::move(rhs.depth);
+			FBO = rhs.FBO;
+			rhs.FBO = ~0;
+			return *this;
+		}
+		~FlatFrameBuffer() { if (~FBO) glDeleteFramebuffers(1, &FBO); }
+		//ֻһ棬face
+		void use_face(int) { glBindFramebuffer(GL_FRAMEBUFFER, FBO); }
+		void bind(int id_geometry_flux_depth) const {
+			int id = id_geometry_flux_depth;
+			geometry.bind(id); flux.bind(id + 1); depth.bind(id + 2);
+		}
+		void generate_mipmap() const {
+			glActiveTexture(GL_TEXTURE15);
+			glBindTexture(GL_TEXTURE_2D, geometry.id());
+			glGenerateMipmap(GL_TEXTURE_2D);
+			glBindTexture(GL_TEXTURE_2D, flux.id());
+			glGenerateMipmap(GL_TEXTURE_2D);
+		}
+		//ѵlevelǰ󶨵GL_PIXEL_PACK_BUFFERУgeometryRGBA floatǰfluxRGB floatflux_offsetʼ
+		void read(int level, size_t flux_offset) const {
+			glActiveTexture(GL_TEXTURE15);
+			glBindTexture(GL_TEXTURE_2D, geometry.id());
+			glGetTexImage(GL_TEXTURE_2D, level, GL_RGBA, GL_FLOAT, (void*)0);
+			glBindTexture(GL_TEXTURE_2D, flux.id());
+			glGetTexImage(GL_TEXTURE_2D, level, GL_RGB, GL_FLOAT, (void*)flux_offset);
+		}
+		void copy_from(const FlatFrameBuffer& src, int width, int height) {
+			const unsigned* fbo = copy_framebuffers();
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo[0]);
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo[1]);
+			const Texture* pairs[3][2] = { { &src.geometry, &geometry }, { &src.flux, &flux }, { &src.depth, &depth } };
+			for (int i = 0; i < 3; ++i) {
+				GLenum attachment = i < 2 ? GL_COLOR_ATTACHMENT0 : GL_DEPTH_ATTACHMENT;
+				GLbitfield mask = i < 2 ? GL_COLOR_BUFFER_BIT : GL_DEPTH_BUFFER_BIT;
+				glReadBuffer(i < 2 ? attachment : GL_NONE);
+				glDrawBuffer(i < 2 ? attachment : GL_NONE);
+				glFramebufferTexture2D(GL_READ_FRAMEBUFFER, attachment, GL_TEXTURE_2D, pairs[i][0]->id(), 0);
+				glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, attachment, GL_TEXTURE_2D, pairs[i][1]->id(), 0);
+				glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, mask, GL_NEAREST);
+				//ȸŵǰȽɫţָͬʱ
+				glFramebufferTexture2D(GL_READ_FRAMEBUFFER, attachment, GL_TEXTURE_2D, 0, 0);
+				glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, attachment, GL_TEXTURE_2D, 0, 0);
+			}
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		}
+	};
+
+	//壬ݴڻУɫͨtexelFetchȡ
+	class TextureBuffer {
+		unsigned buffer, uid;
+
+	public:
+		TextureBuffer() :buffer(~0), uid(~0) {}
+		TextureBuffer(GLenum format) :buffer(~0), uid(~0) {
+			glGenBuffers(1, &buffer);
+			glGenTextures(1, &uid);
+			glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+			glActiveTexture(GL_TEXTURE15);
+			glBindTexture(GL_TEXTURE_BUFFER, uid);
+			glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+			glBindBuffer(GL_TEXTURE_BUFFER, 0);
+		}
+		TextureBuffer(const TextureBuffer&) = delete;
+		TextureBuffer(TextureBuffer&& rhs) noexcept :buffer(rhs.buffer), uid(rhs.uid) {
+			rhs.buffer = rhs.uid = ~0;
+		}
+		TextureBuffer& operator=(TextureBuffer&& rhs) noexcept {
+			if (~uid) glDeleteTextures(1, &uid), glDeleteBuffers(1, &buffer);
+			buffer = rhs.buffer;
+			uid = rhs.uid;
+			rhs.buffer = rhs.uid = ~0;
+			return *this;
+		}
+		~TextureBuffer() { if (~uid) glDeleteTextures(1, &uid), glDeleteBuffers(1, &buffer); }
+
+		//ϴݣÿ·洢ҪȴGPUһ֡
+		void upload(const void* data, size_t size) {
+			glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+			glBufferData(GL_TEXTURE_BUFFER, size, data, GL_STREAM_DRAW);
+			glBindBuffer(GL_TEXTURE_BUFFER, 0);
+		}
+
+		inline void bind(unsigned index) const {
+			if (index >= 15) std::cerr << "ERROR::TEXTURE::INVALID_BIND_INDEX" << std::endl;
+			glActiveTexture(GL_TEXTURE0 + index);
+			glBindTexture(GL_TEXTURE_BUFFER, uid);
+		}
+	};
+
+	//ӳȾG-bufferɫ淴ɫȣԼۼӹսɫ
+	class GBuffer {
+		Texture albedo, specular, normal, light;
+		unsigned FBO, RBO; //RBOΪȺģ建
+		int width, height;
+
+	public:
+		GBuffer() :FBO(~0), RBO(~0), width(0), height(0) {}
+		GBuffer(GBuffer&& rhs) noexcept :
+			albedo(std::move(rhs.albedo)),
+			specular(std::move(rhs.specular)),
+			normal(std::move(rhs.normal)),
+			light(std::move(rhs.light)),
+			FBO(rhs.FBO), RBO(rhs.RBO), width(rhs.width), height(rhs.height)
+		{
+			rhs.FBO = rhs.RBO = ~0;
+		}
+		GBuffer(int width, int height) :
+			albedo(GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST),
+			specular(GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST),
+			normal(GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST),
+			light(GL_CLAMP_TO_EDGE, GL_NEAREST, GL_NEAREST),
+			FBO(~0), RBO(~0), width(width), height(height)
+		{
+			albedo.storage(GL_RGBA8, width, height, GL_UNSIGNED_BYTE);
+			specular.storage(GL_RGBA8, width, height, GL_UNSIGNED_BYTE);
+			normal.storage(GL_RGBA16F, width, height, GL_FLOAT);
+			light.storage(GL_RGBA16F, width, height, GL_FLOAT);
+			glGenRenderbuffers(1, &RBO);
+			glBindRenderbuffer(GL_RENDERBUFFER, RBO);
+			glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+			glGenFramebuffers(1, &FBO);
+			glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+			glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, albedo.id(), 0);
+			glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, specular.id(), 0);
+			glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, normal.id(), 0);
+			glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT3, light.id(), 0);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, RBO);
+			if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+				std::cerr << "ERROR::FRAMEBUFFER::GBUFFER_INCOMPLETE" << std::endl;
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		}
+		GBuffer& operator=(GBuffer&& rhs) noexcept {
+			if (~FBO) glDeleteFramebuffers(1, &FBO);
+			if (~RBO) glDeleteRenderbuffers(1, &RBO);
+			albedo = std::move(rhs.albedo);
+			specular = std::move(rhs.specular);
+			normal = std::move(rhs.normal);
+			light = std::move(rhs.light);
+			FBO = rhs.FBO;
+			RBO = rhs.RBO;
+			width = rhs.width;
+			height = rhs.height;
+			rhs.FBO = rhs.RBO = ~0;
+			return *this;
+		}
+		~GBuffer() {
+			if (~FBO) glDeleteFramebuffers(1, &FBO);
+			if (~RBO) glDeleteRenderbuffers(1, &RBO);
+		}
+
+		//passдǰɫ
+		void use_geometry() {
+			glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+			unsigned attachments[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+			glDrawBuffers(3, attachments);
+		}
+
+		//passдջ壬G-bufferΰ󶨵idʼԪ
+		void use_lighting(int id_albedo_specular_normal) {
+			int id = id_albedo_specular_normal;
+			glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+			glDrawBuffer(GL_COLOR_ATTACHMENT3);
+			albedo.bind(id); specular.bind(id + 1); normal.bind(id + 2);
+		}
+
+		//ѹսȸƵĬ֡
+		void blit() {
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, FBO);
+			glReadBuffer(GL_COLOR_ATTACHMENT3);
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+			glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
 		}
 	};
 
@@ -0,0 +1,48 @@
+#pragma once
+#include "basic.h"
+
+namespace illusion {
+
+	//GPUʱGL_TIME_ELAPSEDѯһGPUϵĺʱ
+	//ѯʹãȡǰһεĽȴGPU
+	class GpuTimer {
+		unsigned queries[2];
+		int current;
+		bool started[2];
+		float last; //һȡصĺʱ룩
+		float average; //ָƽ룩
+
+	public:
+		GpuTimer() :current(0), started{ false, false }, last(0.0f), average(0.0f) {
+			glGenQueries(2, queries);
+		}
+		GpuTimer(const GpuTimer&) = delete;
+		~GpuTimer() { glDeleteQueries(2, queries); }
+
+		void begin() {
+			int prev = current ^ 1;
+			if (started[prev]) {
+				unsigned available = 0;
+				glGetQueryObjectuiv(queries[prev], GL_QUERY_RESULT_AVAILABLE, &available);
+				if (available) {
+					GLuint64 ns = 0;
+					glGetQueryObjectui64v(queries[prev], GL_QUERY_RESULT, &ns);
+					last = ns * 1e-6f;
+					average = average == 0.0f ? last : average * 0.95f + last * 0.05f;
+					started[prev] = false;
+				}
+			}
+			glBeginQuery(GL_TIME_ELAPSED, queries[current]);
+		}
+
+		void end() {
+			glEndQuery(GL_TIME_ELAPSED);
+			started[current] = true;
+			current ^= 1;
+		}
+
+		float ms() const { return last; }
+		float average_ms() const { return average; }
+	};
+
+}
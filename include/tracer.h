@@ -0,0 +1,258 @@
+#pragma once
+#include "bound.h"
+#include <vector>
+#include <algorithm>
+#include <cfloat>
+
+namespace illusion {
+
+	//CPUõ4BVHSAHٰ֣ϲ4ڵ㣬
+	//ÿڵ4ӰΧаSoAУһSSE4Χ
+	//ֻԱ߳ͬʱѯ
+	class TriangleBVH {
+		static constexpr unsigned bin_num = 12; //SAHʱÿͰ
+		static constexpr unsigned max_leaf = 4; //Ҷӽڵ
+		static constexpr int max_depth = 64; //ջĴС
+		static constexpr int sah_depth = 40; //һλ֣ʣĲlog4()
+
+		struct Node {
+			float min[3][4], max[3][4]; //4ӽڵİΧУmin[axis][child]
+			int child[4]; //ǸΪڲڵţΪ~Ҷӱ
+			int num; //Чӽڵ
+		};
+
+		struct Leaf {
+			unsigned first, count; //trisе
+		};
+
+		//ԤȼΣMoller-Trumbore
+		struct Triangle {
+			glm::vec3 v0, e1, e2;
+		};
+
+		std::vector<Node> nodes;
+		std::vector<Leaf> leaves;
+		std::vector<Triangle> tris; //Ҷ˳е
+		std::vector<unsigned> ids; //trisÿεԭʼ
+		std::vector<AABB> boxes; //ʱÿεİΧ
+		std::vector<glm::vec3> centers;
+
+		static unsigned bin_of(float c, float lo, float hi) {
+			unsigned b = (unsigned)((c - lo) / (hi - lo) * bin_num);
+			return b < bin_num ? b : bin_num - 1;
+		}
+
+		AABB range_box(unsigned first, unsigned count) const {
+			AABB box;
+			for (unsigned i = first; i < first + count; ++i) box.extend(boxes[ids[i]]);
+			return box;
+		}
+
+		//һάλ֣ͬ
+		unsigned median_split(const AABB& centroid, unsigned first, unsigned count) {
+			glm::vec3 extent = centroid.max - centroid.min;
+			int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+			unsigned mid = first + count / 2;
+			std::nth_element(ids.begin() + first, ids.begin() + mid, ids.begin() + first + count,
+							 [this, axis](unsigned a, unsigned b) { return centers[a][axis] < centers[b][axis]; });
+			return mid;
+		}
+
+		//SAH[first, first + count)Ұ벿ֵ㣬޷ֻmedianΪtrueʱλ
+		unsigned split(unsigned first, unsigned count, bool median) {
+			AABB centroid;
+			for (unsigned i = first; i < first + count; ++i) centroid.extend(centers[ids[i]]);
+			if (median) return median_split(centroid, first, count);
+			float best_cost = FLT_MAX;
+			int best_axis = -1;
+			unsigned best_split = 0;
+			for (int axis = 0; axis < 3; ++axis) {
+				float lo = centroid.min[axis], hi = centroid.max[axis];
+				if (hi <= lo) continue;
+				AABB bin_box[bin_num];
+				unsigned bin_count[bin_num] = {};
+				for (unsigned i = first; i < first + count; ++i) {
+					unsigned b = bin_of(centers[ids[i]][axis], lo, hi);
+					bin_box[b].extend(boxes[ids[i]]);
+					++bin_count[b];
+				}
+				float left_area[bin_num - 1];
+				unsigned left_count[bin_num - 1];
+				AABB acc;
+				unsigned n = 0;
+				for (unsigned b = 0; b < bin_num - 1; ++b) {
+					acc.extend(bin_box[b]);
+					n += bin_count[b];
+					left_area[b] = acc.area();
+					left_count[b] = n;
+				}
+				acc = AABB();
+				n = 0;
+				for (unsigned b = bin_num - 1; b > 0; --b) {
+					acc.extend(bin_box[b]);
+					n += bin_count[b];
+					float cost = left_area[b - 1] * left_count[b - 1] + acc.area() * n;
+					if (left_count[b - 1] && n && cost < best_cost) {
+						best_cost = cost;
+						best_axis = axis;
+						best_split = b;
+					}
+				}
+			}
+			if (best_axis < 0) return median_split(centroid, first, count);
+			float lo = centroid.min[best_axis], hi = centroid.max[best_axis];
+			unsigned i = first, j = first + count;
+			while (i < j) {
+				if (bin_of(centers[ids[i]][best_axis], lo, hi) < best_split) ++i;
+				else std::swap(ids[i], ids[--j]);
+			}
+			return i;
+		}
+
+		//㹻ʱΪҶӣݹ鹹ڲڵ㣬ӽڵı룬depthΪڵڵĲ
+		int build_child(unsigned first, unsigned count, int depth) {
+			if (count <= max_leaf) {
+				leaves.push_back(Leaf{ first, count });
+				return ~int(leaves.size() - 1);
+			}
+			return build_node(first, count, depth);
+		}
+
+		//εõ4䣬ʱλ֣֤max_depth
+		int build_node(unsigned first, unsigned count, int depth) {
+			bool median = depth >= sah_depth;
+			unsigned mid = split(first, count, median);
+			unsigned range[4][2];
+			int n = 0;
+			unsigned halves[2][2] = { { first, mid - first }, { mid, first + count - mid } };
+			for (auto& h : halves) {
+				if (h[1] > max_leaf) {
+					unsigned m = split(h[0], h[1], median);
+					range[n][0] = h[0], range[n++][1] = m - h[0];
+					range[n][0] = m, range[n++][1] = h[0] + h[1] - m;
+				} else range[n][0] = h[0], range[n++][1] = h[1];
+			}
+			int id = nodes.size();
+			nodes.emplace_back();
+			nodes[id].num = n;
+			for (int c = 0; c < 4; ++c) {
+				AABB box = c < n ? range_box(range[c][0], range[c][1]) : AABB(glm::vec3(0.0f), glm::vec3(0.0f));
+				for (int axis = 0; axis < 3; ++axis) {
+					nodes[id].min[axis][c] = box.min[axis];
+					nodes[id].max[axis][c] = box.max[axis];
+				}
+				nodes[id].child[c] = 0;
+			}
+			for (int c = 0; c < n; ++c) {
+				int child = build_child(range[c][0], range[c][1], depth + 1);
+				nodes[id].child[c] = child;
+			}
+			return id;
+		}
+
+		//ཻӽڵ룬t_maxΪǰĽ
+		static int intersect4(const Node& node, const __m128 origin[3], const __m128 inv_dir[3], float t_max) {
+			__m128 t0 = _mm_setzero_ps(), t1 = _mm_set1_ps(t_max);
+			for (int axis = 0; axis < 3; ++axis) {
+				__m128 lo = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.min[axis]), origin[axis]), inv_dir[axis]);
+				__m128 hi = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.max[axis]), origin[axis]), inv_dir[axis]);
+				t0 = _mm_max_ps(t0, _mm_min_ps(lo, hi));
+				t1 = _mm_min_ps(t1, _mm_max_ps(lo, hi));
+			}
+			return _mm_movemask_ps(_mm_cmple_ps(t0, t1)) & ((1 << node.num) - 1);
+		}
+
+		static bool intersect(const Triangle& tri, const glm::vec3& origin, const glm::vec3& dir, float& t) {
+			glm::vec3 p = glm::cross(dir, tri.e2);
+			float det = glm::dot(tri.e1, p);
+			if (std::abs(det) < 1e-12f) return false;
+			float inv = 1.0f / det;
+			glm::vec3 s = origin - tri.v0;
+			float u = glm::dot(s, p) * inv;
+			if (u < 0.0f || u > 1.0f) return false;
+			glm::vec3 q = glm::cross(s, tri.e1);
+			float v = glm::dot(dir, q) * inv;
+			if (v < 0.0f || u + v > 1.0f) return false;
+			t = glm::dot(tri.e2, q) * inv;
+			return t > 0.0f;
+		}
+
+		//anyΪtrueʱҵ⽻㼴أӰ
+		template<bool any>
+		bool traverse(const glm::vec3& origin, const glm::vec3& dir, float& t_max, unsigned& hit) const {
+			if (nodes.empty() && leaves.empty()) return false;
+			__m128 o[3], inv[3];
+			for (int axis = 0; axis < 3; ++axis) {
+				o[axis] = _mm_set1_ps(origin[axis]);
+				//Ϊ0ʱúܴ0 * infõNaN
+				float d = std::abs(dir[axis]) > 1e-20f ? dir[axis] : 1e-20f;
+				inv[axis] = _mm_set1_ps(1.0f / d);
+			}
+			bool found = false;
+			int stack[max_depth * 4]; //ÿ3ʵֵܽڵ
+			int top = 0;
+			stack[top++] = nodes.empty() ? ~0 : 0;
+			while (top) {
+				int id = stack[--top];
+				if (id < 0) {
+					const Leaf& leaf = leaves[~id];
+					for (unsigned i = leaf.first; i < leaf.first + leaf.count; ++i) {
+						float t;
+						if (intersect(tris[i], origin, dir, t) && t < t_max) {
+							t_max = t;
+							hit = ids[i];
+							found = true;
+							if (any) return true;
+						}
+					}
+					continue;
+				}
+				const Node& node = nodes[id];
+				int mask = intersect4(node, o, inv, t_max);
+				for (int c = 0; c < node.num; ++c)
+					if (mask >> c & 1) stack[top++] = node.child[c];
+			}
+			return found;
+		}
+
+	public:
+		//positionsÿ3һ
+		void build(const std::vector<glm::vec3>& positions) {
+			unsigned n = positions.size() / 3;
+			nodes.clear();
+			leaves.clear();
+			boxes.resize(n);
+			centers.resize(n);
+			ids.resize(n);
+			for (unsigned i = 0; i < n; ++i) {
+				boxes[i] = AABB();
+				for (int j = 0; j < 3; ++j) boxes[i].extend(positions[i * 3 + j]);
+				centers[i] = boxes[i].center();
+				ids[i] = i;
+			}
+			if (n) build_child(0, n, 0);
+			tris.resize(n);
+			for (unsigned i = 0; i < n; ++i) {
+				const glm::vec3* v = &positions[ids[i] * 3];
+				tris[i] = Triangle{ v[0], v[1] - v[0], v[2] - v[0] };
+			}
+			boxes.clear();
+			boxes.shrink_to_fit();
+			centers.clear();
+			centers.shrink_to_fit();
+		}
+
+		//Ľ㣬ǷཻtΪ룬hitΪα
+		bool closest(const glm::vec3& origin, const glm::vec3& dir, float& t, unsigned& hit) const {
+			t = FLT_MAX;
+			return traverse<false>(origin, dir, t, hit);
+		}
+
+		//[0, t_max)Ƿڵ
+		bool occluded(const glm::vec3& origin, const glm::vec3& dir, float t_max) const {
+			unsigned hit;
+			return traverse<true>(origin, dir, t_max, hit);
+		}
+	};
+
+}
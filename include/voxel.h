@@ -0,0 +1,179 @@
+#pragma once
+#include "shader.h"
+#include "texture.h"
+#include "bound.h"
+#include "light.h"
+
+namespace illusion {
+
+	//Բ׶׷٣ѳػǳ3DУõԴӰעֱӹ⣬
+	//mipmapɫʱԲ׶õ͸߹ļӹ
+	//GL 3.3ûimage storeػ÷ֲȾʵ֣ɫηķѡͶӰᣬ
+	//Ӧۻǵĸ㣬Ƭüӷۼӷʺͷ
+	class VoxelVolume {
+	public:
+		static constexpr int size = 64; //ÿһάĸ
+
+	private:
+		static constexpr int unit = 9; //󶨵Ԫ
+		static constexpr int accum_unit = 2; //עʱ6ۻ󶨵ʼԪ
+		static constexpr int layer_num = 16; //ÿλĲܼɫ
+		static constexpr float intensity = 1.0f; //ɫʱӹǿ
+
+		Program voxelize_prog, inject_prog;
+		unsigned accum[6]; //xyzͶӰķʺͷۻ
+		unsigned radiance; //ϲĳȣmipmap
+		unsigned voxel_FBO, inject_FBO;
+		unsigned empty_VAO;
+		AABB box; //񸲸ǵķΧ
+		float cell; //ӵı߳
+		bool dirty;
+
+	public:
+		VoxelVolume() :accum{}, radiance(~0), voxel_FBO(~0), inject_FBO(~0), empty_VAO(~0), cell(1.0f), dirty(true) {
+			for (auto& t : accum) t = ~0;
+		}
+		VoxelVolume(const VoxelVolume&) = delete;
+		~VoxelVolume() {
+			for (auto f : { voxel_FBO, inject_FBO }) if (~f) glDeleteFramebuffers(1, &f);
+			for (auto t : accum) if (~t) glDeleteTextures(1, &t);
+			if (~radiance) glDeleteTextures(1, &radiance);
+			if (~empty_VAO) glDeleteVertexArrays(1, &empty_VAO);
+		}
+
+		//Ӱͼdepth_unitϣnearfarΪ͸ͶӰĽƽԶƽ
+		bool init(const Program& target, int depth_unit, float near, float far) {
+			Shader voxelize_vs(GL_VERTEX_SHADER, "./shader/voxelize.vs");
+			Shader voxelize_gs(GL_GEOMETRY_SHADER, "./shader/voxelize.gs");
+			Shader voxelize_fs(GL_FRAGMENT_SHADER, "./shader/voxelize.fs");
+			Shader inject_vs(GL_VERTEX_SHADER, "./shader/lpv_propagate.vs");
+			Shader inject_gs(GL_GEOMETRY_SHADER, "./shader/lpv_propagate.gs");
+			Shader inject_fs(GL_FRAGMENT_SHADER, "./shader/voxel_inject.fs");
+			if (voxelize_vs.fail() || voxelize_gs.fail() || voxelize_fs.fail() || inject_vs.fail() || inject_gs.fail() || inject_fs.fail()
+				|| !voxelize_prog.link(voxelize_vs, voxelize_fs, voxelize_gs) || !inject_prog.link(inject_vs, inject_fs, inject_gs)) return false;
+
+			glGenTextures(6, accum);
+			for (int i = 0; i < 6; ++i) {
+				glActiveTexture(GL_TEXTURE15);
+				glBindTexture(GL_TEXTURE_3D, accum[i]);
+				glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA16F, size, size, size, 0, GL_RGBA, GL_FLOAT, NULL);
+				glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+				glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			}
+			glGenTextures(1, &radiance);
+			glBindTexture(GL_TEXTURE_3D, radiance);
+			glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA16F, size, size, size, 0, GL_RGBA, GL_FLOAT, NULL);
+			glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+			glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			//ûڵҲûй
+			glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+			glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+			glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_BORDER);
+			float border[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			glTexParameterfv(GL_TEXTURE_3D, GL_TEXTURE_BORDER_COLOR, border);
+			glGenerateMipmap(GL_TEXTURE_3D);
+
+			unsigned attachments[6];
+			for (int i = 0; i < 6; ++i) attachments[i] = GL_COLOR_ATTACHMENT0 + i;
+			glGenFramebuffers(1, &voxel_FBO);
+			glBindFramebuffer(GL_FRAMEBUFFER, voxel_FBO);
+			for (int i = 0; i < 6; ++i) glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, accum[i], 0);
+			glDrawBuffers(6, attachments);
+			if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+				std::cerr << "ERROR::FRAMEBUFFER::VOXEL_INCOMPLETE" << std::endl;
+			glGenFramebuffers(1, &inject_FBO);
+			glBindFramebuffer(GL_FRAMEBUFFER, inject_FBO);
+			glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, radiance, 0);
+			if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+				std::cerr << "ERROR::FRAMEBUFFER::VOXEL_INJECT_INCOMPLETE" << std::endl;
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			glGenVertexArrays(1, &empty_VAO);
+
+			voxelize_prog.set("voxel_size", size);
+			const char* names[6] = { "albedo_x", "albedo_y", "albedo_z", "normal_x", "normal_y", "normal_z" };
+			for (int i = 0; i < 6; ++i) inject_prog.set(names[i], accum_unit + i);
+			inject_prog.set("depth_map", depth_unit);
+			inject_prog.set("shadow_near", near);
+			inject_prog.set("far_plane", far);
+			target.set("voxel_radiance", unit);
+			target.set("voxel_intensity", intensity);
+			return true;
+		}
+
+		//񸲸ǳΪ壬һάһ
+		void set_bounds(const Program& target, const AABB& scene) {
+			if (scene.empty()) return;
+			glm::vec3 extent = scene.max - scene.min;
+			cell = std::max(std::max(extent.x, extent.y), std::max(extent.z, 1e-3f)) / (size - 2);
+			glm::vec3 half(cell * size * 0.5f);
+			box = AABB(scene.center() - half, scene.center() + half);
+			for (const Program* prog : { &voxelize_prog, &inject_prog }) {
+				prog->set("voxel_min", box.min);
+				prog->set("voxel_cell", cell);
+			}
+			target.set("voxel_min", box.min);
+			target.set("voxel_extent", cell * size);
+			target.set("voxel_cell", cell);
+			dirty = true;
+		}
+
+		//ƶRSM»ƺ
+		void invalidate() { dirty = true; }
+
+		//Ҫʱػעֱӹ⣬ѷ󶨵ɫpassʹõԪϣǷ¼
+		//draw(prog)lightΪͶӰĵԴ
+		template<typename F>
+		bool update(const PointLight& light, F&& draw) {
+			bool ret = dirty && !box.empty();
+			if (ret) {
+				glDisable(GL_DEPTH_TEST);
+				glDisable(GL_CULL_FACE);
+				glViewport(0, 0, size, size);
+				glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+				glBindFramebuffer(GL_FRAMEBUFFER, voxel_FBO);
+				glClear(GL_COLOR_BUFFER_BIT);
+
+				//ػÿλƸlayer_num㣬üڲķΧ
+				glEnable(GL_BLEND);
+				glBlendFunc(GL_ONE, GL_ONE);
+				glEnable(GL_CLIP_DISTANCE0);
+				glEnable(GL_CLIP_DISTANCE1);
+				for (int offset = 0; offset < size; offset += layer_num) {
+					voxelize_prog.set("layer_offset", offset);
+					draw(voxelize_prog);
+				}
+				glDisable(GL_CLIP_DISTANCE0);
+				glDisable(GL_CLIP_DISTANCE1);
+				glDisable(GL_BLEND);
+
+				//ϲ3ͶӰᲢעֱӹ⣬ÿʵӦһ
+				glBindFramebuffer(GL_FRAMEBUFFER, inject_FBO);
+				for (int i = 0; i < 6; ++i) {
+					glActiveTexture(GL_TEXTURE0 + accum_unit + i);
+					glBindTexture(GL_TEXTURE_3D, accum[i]);
+				}
+				inject_prog.set("light.pos", light.pos);
+				inject_prog.set("light.constant", light.constant);
+				inject_prog.set("light.linear", light.linear);
+				inject_prog.set("light.quadratic", light.quadratic);
+				inject_prog.set("light.diffuse", light.diffuse);
+				inject_prog.apply();
+				glBindVertexArray(empty_VAO);
+				glDrawArraysInstanced(GL_TRIANGLES, 0, 3, size);
+				glBindVertexArray(0);
+				glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+				glActiveTexture(GL_TEXTURE0 + unit);
+				glBindTexture(GL_TEXTURE_3D, radiance);
+				glGenerateMipmap(GL_TEXTURE_3D);
+				glEnable(GL_DEPTH_TEST);
+				glEnable(GL_CULL_FACE);
+				dirty = false;
+			}
+			glActiveTexture(GL_TEXTURE0 + unit);
+			glBindTexture(GL_TEXTURE_3D, radiance);
+			return ret;
+		}
+	};
+
+}
@@ -0,0 +1,290 @@
+#pragma once
+#include "shader.h"
+#include "texture.h"
+#include <vector>
+#include <chrono>
+
+namespace illusion {
+
+	//RSMȡԴVPLRSM»ƺѽϴֵmipmap첽صPBOУ
+	//֮֡CPUϰͨҪѡѡtexelk-meansVPLϴuniform buffer
+	//ӹpassÿVPL㣬صԲ̲
+	class VplSet {
+	public:
+		static constexpr int max_vpl_num = 64; //ҪɫеMAX_VPL_NUMһ
+
+	private:
+		static constexpr unsigned binding = 1; //uniform bufferİ󶨵㣬0RSMʹ
+		static constexpr int read_size = 32; //صmipmapֱ
+		static constexpr int candidate_num = 256; //Ҫѡĺѡtexel
+		static constexpr int iteration_num = 8; //k-meansĵ
+		static constexpr float normal_weight = 0.5f; //зȨأڵԴƽ룩
+
+		struct Candidate {
+			glm::vec3 pos, normal, flux;
+			float lum;
+		};
+
+		//ʱRSMĹԴؽλ
+		struct Source {
+			bool flat; //ǷΪ۹ƻƽй2D RSM
+			bool ortho; //2D RSMǷΪͶӰ
+			glm::vec3 pos; //Դλã2D RSMʱΪԴ۲ռԭ
+			glm::mat4 inv_view; //2D RSMĹԴ۲
+			glm::vec2 scale; //2D RSMͶӰ͸ͶӰΪ׶ǵУͶӰΪͰ
+		};
+
+		unsigned UBO, PBO[2];
+		GLsync fences[2];
+		Source sources[2];
+		unsigned seq[2]; //صţֻɵһ
+		unsigned counter;
+		int write; //һζʹõPBO
+		int level; //صmipmap㼶
+		int size; //صmipmapķֱ
+		int vpl_num; //ǰЧVPL
+		int cluster_num; //Ŀ
+		float cube_scale, flat_scale; //VPLͨţʹԲ̲һ
+		float cpu_ms; //һȡ;CPUϵĺʱ룩
+
+		size_t geometry_bytes(int faces = 6) const { return size_t(size) * size * faces * 4 * sizeof(float); }
+		size_t flux_bytes(int faces = 6) const { return size_t(size) * size * faces * 3 * sizeof(float); }
+
+		//ͼface(s, t)ӦķGLͼԼһ
+		static glm::vec3 cube_dir(int face, float s, float t) {
+			float sc = s * 2.0f - 1.0f, tc = t * 2.0f - 1.0f;
+			switch (face) {
+			case 0: return glm::vec3(1.0f, -tc, -sc);
+			case 1: return glm::vec3(-1.0f, -tc, sc);
+			case 2: return glm::vec3(sc, 1.0f, tc);
+			case 3: return glm::vec3(sc, -1.0f, -tc);
+			case 4: return glm::vec3(sc, -tc, 1.0f);
+			default: return glm::vec3(-sc, -tc, -1.0f);
+			}
+		}
+
+		static glm::vec3 oct_decode(float x, float y) {
+			glm::vec3 n(x, y, 1.0f - std::abs(x) - std::abs(y));
+			if (n.z < 0.0f) {
+				float nx = (1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f);
+				float ny = (1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+				n.x = nx, n.y = ny;
+			}
+			return glm::normalize(n);
+		}
+
+		static float luminance(const glm::vec3& c) { return glm::dot(c, glm::vec3(0.2126f, 0.7152f, 0.0722f)); }
+
+		//ȷֲѡtexelͬһtexelѡʱϲȨ
+		std::vector<Candidate> extract(const float* geometry, const float* flux, const Source& source) const {
+			int texel_num = size * size * (source.flat ? 1 : 6);
+			std::vector<float> lum(texel_num);
+			float total = 0.0f;
+			for (int i = 0; i < texel_num; ++i) {
+				lum[i] = geometry[i * 4 + 2] > 0.0f ? luminance(glm::make_vec3(flux + i * 3)) : 0.0f;
+				total += lum[i];
+			}
+			std::vector<Candidate> ret;
+			if (total <= 0.0f) return ret;
+			float step = total / candidate_num, target = step * 0.5f, sum = 0.0f;
+			for (int i = 0; i < texel_num && target < total; ++i) {
+				sum += lum[i];
+				int hit = 0;
+				while (target < sum) ++hit, target += step;
+				if (!hit) continue;
+				int face = i / (size * size), x = i % size, y = i / size % size;
+				const float* g = geometry + i * 4;
+				glm::vec3 pos;
+				if (source.flat) {
+					//ڹԴ۲ռؽλ
+					glm::vec2 ndc((x + 0.5f) / size * 2.0f - 1.0f, (y + 0.5f) / size * 2.0f - 1.0f);
+					glm::vec2 xy = ndc * source.scale * (source.ortho ? 1.0f : g[2]);
+					pos = glm::vec3(source.inv_view * glm::vec4(xy, -g[2], 1.0f));
+				} else pos = source.pos + glm::normalize(cube_dir(face, (x + 0.5f) / size, (y + 0.5f) / size)) * g[2];
+				//ÿѡtotal / candidate_numȣͨѡеĸʲ
+				float w = hit * step / lum[i];
+				float s = source.flat ? flat_scale : cube_scale;
+				ret.push_back({ pos, oct_decode(g[0], g[1]), glm::make_vec3(flux + i * 3) * (w * s), lum[i] * w });
+			}
+			return ret;
+		}
+
+		//k-means࣬ͬʱλúͷʼڰtexel˳еĺѡеȼѡȡ
+		std::vector<Candidate> cluster(const std::vector<Candidate>& candidates, const glm::vec3& origin) const {
+			int n = int(candidates.size()), k = std::min(cluster_num, n);
+			if (n <= k) return candidates;
+			float mean_distance = 0.0f;
+			for (auto& c : candidates) mean_distance += glm::length(c.pos - origin) / n;
+			float normal_scale = normal_weight * mean_distance * mean_distance;
+
+			std::vector<Candidate> centers(k);
+			for (int j = 0; j < k; ++j) centers[j] = candidates[j * n / k];
+			std::vector<int> owner(n, 0);
+			for (int it = 0; it < iteration_num; ++it) {
+				bool changed = false;
+				for (int i = 0; i < n; ++i) {
+					float best = FLT_MAX;
+					int best_j = 0;
+					for (int j = 0; j < k; ++j) {
+						glm::vec3 d = candidates[i].pos - centers[j].pos;
+						float dist = glm::dot(d, d) + normal_scale * (1.0f - glm::dot(candidates[i].normal, centers[j].normal));
+						if (dist < best) best = dist, best_j = j;
+					}
+					if (owner[i] != best_j || it == 0) changed = true;
+					owner[i] = best_j;
+				}
+				if (!changed) break;
+				//ΪȼȨλãΪȨ͵ķͨΪܺ
+				std::vector<Candidate> next(k, Candidate{ glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f), 0.0f });
+				for (int i = 0; i < n; ++i) {
+					auto& c = next[owner[i]];
+					c.pos += candidates[i].pos * candidates[i].lum;
+					c.normal += candidates[i].normal * candidates[i].lum;
+					c.flux += candidates[i].flux;
+					c.lum += candidates[i].lum;
+				}
+				for (int j = 0; j < k; ++j) {
+					if (next[j].lum <= 0.0f) continue; //յľౣԭ
+					next[j].pos /= next[j].lum;
+					float len = glm::length(next[j].normal);
+					next[j].normal = len > 0.0f ? next[j].normal / len : centers[j].normal;
+					centers[j] = next[j];
+				}
+			}
+			//ûз䵽ѡ
+			std::vector<Candidate> ret;
+			std::vector<bool> used(k, false);
+			for (int i = 0; i < n; ++i) used[owner[i]] = true;
+			for (int j = 0; j < k; ++j) if (used[j]) ret.push_back(centers[j]);
+			return ret;
+		}
+
+		int begin_read() {
+			int i = write;
+			write ^= 1;
+			if (fences[i]) glDeleteSync(fences[i]);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, PBO[i]);
+			return i;
+		}
+
+		void end_read(int i, const Source& source) {
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			fences[i] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			sources[i] = source;
+			seq[i] = ++counter;
+		}
+
+		void upload(const Program& prog, const std::vector<Candidate>& vpls) {
+			glm::vec4 data[max_vpl_num * 3] = {};
+			vpl_num = std::min(int(vpls.size()), max_vpl_num);
+			for (int i = 0; i < vpl_num; ++i) {
+				data[i] = glm::vec4(vpls[i].pos, 1.0f);
+				data[max_vpl_num + i] = glm::vec4(vpls[i].normal, 0.0f);
+				data[max_vpl_num * 2 + i] = glm::vec4(vpls[i].flux, 0.0f);
+			}
+			glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+			glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(data), data);
+			glBindBuffer(GL_UNIFORM_BUFFER, 0);
+			prog.set("vpl_num", vpl_num);
+		}
+
+	public:
+		VplSet() :UBO(~0), PBO{ ~0u, ~0u }, fences{ nullptr, nullptr }, seq{ 0, 0 }, counter(0), write(0), level(0), size(1),
+			vpl_num(0), cluster_num(48), cube_scale(1.0f), flat_scale(1.0f), cpu_ms(0.0f) {}
+		VplSet(const VplSet&) = delete;
+		~VplSet() {
+			for (int i = 0; i < 2; ++i) {
+				if (fences[i]) glDeleteSync(fences[i]);
+				if (~PBO[i]) glDeleteBuffers(1, &PBO[i]);
+			}
+			if (~UBO) glDeleteBuffers(1, &UBO);
+		}
+
+		//rsm_sizeΪRSMķֱʣsample_radiusflat_radiusΪRSM2D RSMԲ̲İ뾶
+		void init(const Program& prog, int rsm_size, float sample_radius, float flat_radius) {
+			while ((rsm_size >> level) > read_size) ++level;
+			//Բ̲ĽԲtexelƽֵVPLͨtexelܺͣԲڵtexel
+			//ͼһtexelڵλ봦ı߳Ϊ2/size2D RSMһtexelı߳Ϊ1/size
+			size = std::max(rsm_size >> level, 1);
+			cube_scale = 4.0f / (glm::pi<float>() * sample_radius * sample_radius * size * size);
+			flat_scale = 1.0f / (glm::pi<float>() * flat_radius * flat_radius * size * size);
+			glGenBuffers(1, &UBO);
+			glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+			glBufferData(GL_UNIFORM_BUFFER, max_vpl_num * 3 * sizeof(glm::vec4), NULL, GL_DYNAMIC_DRAW);
+			glBindBuffer(GL_UNIFORM_BUFFER, 0);
+			glGenBuffers(2, PBO);
+			for (int i = 0; i < 2; ++i) {
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, PBO[i]);
+				glBufferData(GL_PIXEL_PACK_BUFFER, geometry_bytes() + flux_bytes(), NULL, GL_STREAM_READ);
+			}
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+			unsigned index = glGetUniformBlockIndex(prog.id(), "Vpls");
+			if (index == GL_INVALID_INDEX) {
+				std::cerr << "ERROR::PROGRAM::INVALID_BLOCK Vpls" << std::endl;
+				return;
+			}
+			glUniformBlockBinding(prog.id(), index, binding);
+			prog.set("vpl_num", 0);
+		}
+
+		//þVPL0ʾرVPLصԲ̲
+		void set_cluster_num(const Program& prog, int num) {
+			cluster_num = std::min(std::max(num, 0), max_vpl_num);
+			if (!cluster_num) vpl_num = 0, prog.set("vpl_num", 0);
+		}
+
+		//RSM»ƲmipmapãѶУȴGPU
+		void request(const FullFrameBuffer& rsm, const glm::vec3& pos) {
+			if (!cluster_num) return;
+			int i = begin_read();
+			rsm.read(level, size, geometry_bytes());
+			end_read(i, Source{ false, false, pos, glm::mat4(1.0f), glm::vec2(1.0f) });
+		}
+
+		//۹ƺƽй2D RSM
+		void request(const FlatFrameBuffer& rsm, const glm::mat4& inv_view, const glm::vec2& scale, bool ortho) {
+			if (!cluster_num) return;
+			int i = begin_read();
+			rsm.read(level, geometry_bytes(1));
+			end_read(i, Source{ true, ortho, glm::vec3(inv_view[3]), inv_view, scale });
+		}
+
+		//ǷɣʱȡVPLǷVPL
+		bool update(const Program& prog) {
+			int latest = -1;
+			for (int i = 0; i < 2; ++i) {
+				if (!fences[i]) continue;
+				GLenum state = glClientWaitSync(fences[i], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+				if ((state == GL_ALREADY_SIGNALED || state == GL_CONDITION_SATISFIED) && (latest < 0 || seq[i] > seq[latest])) latest = i;
+			}
+			if (latest < 0) return false;
+			//ĶѾʱ
+			for (int i = 0; i < 2; ++i)
+				if (fences[i] && seq[i] <= seq[latest]) glDeleteSync(fences[i]), fences[i] = nullptr;
+
+			auto start = std::chrono::steady_clock::now();
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, PBO[latest]);
+			const char* data = (const char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, geometry_bytes() + flux_bytes(), GL_MAP_READ_BIT);
+			if (!data) {
+				std::cerr << "ERROR::VPL::MAP_FAILED" << std::endl;
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+				return false;
+			}
+			const Source& source = sources[latest];
+			size_t flux_offset = geometry_bytes(source.flat ? 1 : 6);
+			std::vector<Candidate> candidates = extract((const float*)data, (const float*)(data + flux_offset), source);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			if (cluster_num) upload(prog, cluster(candidates, source.pos));
+			cpu_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+			return true;
+		}
+
+		void bind() const { glBindBufferBase(GL_UNIFORM_BUFFER, binding, UBO); }
+
+		int get_num() const { return vpl_num; }
+		float get_cpu_ms() const { return cpu_ms; }
+	};
+
+}
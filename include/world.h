@@ -3,6 +3,20 @@
 #include "texture.h"
 #include "mesh.h"
 #include "light.h"
+#include "batch.h"
+#include "bvh.h"
+#include "occlusion.h"
+#include "query.h"
+#include "timer.h"
+#include "deferred.h"
+#include "clustered.h"
+#include "indirect.h"
+#include "shadow.h"
+#include "cascade.h"
+#include "lpv.h"
+#include "probe.h"
+#include "lightmap.h"
+#include "voxel.h"
 #include <queue>
 
 namespace illusion {
@@ -10,7 +24,14 @@ namespace illusion {
 	//࣬ڵȾͽ
 	class World {
 	public:
-		enum class Mode { NO_SHADOW, NORMAL_SHADOW, REFLECTIVE_SHADOW };
+		//LIGHT_PROPAGATIONREFLECTIVE_SHADOWRSMӹΪӹ⴫в
+		//IRRADIANCE_PROBESRSMΪֱӹӰӹӺ決̽в
+		//VOXEL_CONE_TRACINGRSMΪֱӹӰעֱӹ⣬ӹԲ׶׷صõ
+		enum class Mode { NO_SHADOW, NORMAL_SHADOW, REFLECTIVE_SHADOW, DEFERRED, CLUSTERED, LIGHT_PROPAGATION, IRRADIANCE_PROBES, LIGHTMAP, VOXEL_CONE_TRACING };
+		//RSMĹԴͣԴʹRSM۹ƺƽйʹһ2D RSM
+		enum class RsmLight { POINT, SPOT, DIRECTIONAL };
+		//޳ʽ޳аΧ塢BVH
+		enum class Culling { NONE, LINEAR, HIERARCHICAL };
 
 	private:
 		const Mode mode;
@@ -18,16 +39,70 @@ namespace illusion {
 		Program object_prog; //program
 		Program light_prog;
 		Program help_prog;
+		Program depth_prog; //ֻȵprogramԤpass
 		glm::vec3 camera_pos, camera_front, camera_up; //λáϷ
+		glm::mat4 projection; //ͶӰ
 		std::vector<Mesh> objects, point_lights, spot_lights; //ҪȾ󡢵Դ󡢾۹ƶ
 		std::unordered_map<std::string, Texture> texture_map; //ֹͬtextureظ
 
-		FrameBuffer depth;
+		ShadowAtlas shadows; //NORMAL_SHADOWģʽ¶ԴӰ
+		CascadedShadow cascades; //NORMAL_SHADOWģʽƽйļӰ
+		unsigned cascade_draw_num[CascadedShadow::max_cascade_num]; //һ֡ÿڵ
+		std::vector<unsigned> casters; //ڵ
 		FullFrameBuffer rsm_buf;
+		//RSM棺̬廭staticУֻʧЧʱ»ƣ̬帴ƾ̬ٻ
+		FullFrameBuffer rsm_static;
+		std::vector<char> dynamic; //ÿǷƶ
+		unsigned dynamic_num; //̬
+		bool static_dirty, dynamic_dirty; //̬㡢ϳɽǷҪ»
+		bool light_moved; //RSMĹԴǷƶ
+		glm::vec3 shadow_light_pos; //RSMĹԴλ
+		glm::mat4 shadow_matrices[6]; //Դͼ6ͶӰ*۲2D RSMֻʹõ0
+		RsmLight rsm_light; //RSMĹԴ
+		unsigned rsm_light_id; //RSMľ۹Ʊ
+		glm::mat4 rsm_view; //2D RSMĹԴ۲
+		glm::vec2 rsm_scale; //2D RSMͶӰ͸ͶӰΪ׶ǵУͶӰΪͰ
+		FlatFrameBuffer rsm_flat, rsm_flat_static; //۹ƺƽй2D RSM侲̬
+		std::vector<PointLight> point_light_info; //ԴĲ0ԴRSM
+		std::vector<SpotLight> spot_light_info;
+		std::vector<DirLight> dir_light_info;
+		unsigned face_static_num[6], face_dynamic_num[6]; //һθʱÿƵľ̬̬
+		std::vector<glm::vec3> point_light_pos; //ǰȾģʽÿԴλ
+		IndirectPass indirect_pass; //ͷֱʵRSMӹ
+		LightVolume volume; //LIGHT_PROPAGATIONģʽµĹ⴫
+		VoxelVolume voxels; //VOXEL_CONE_TRACINGģʽµ
+		IrradianceProbes probes; //IRRADIANCE_PROBESģʽº決ķն̽
+		Lightmap lightmap; //LIGHTMAPģʽCPU決Ĺͼ
+		GpuTimer indirect_timer; //ӹpass⴫µĺʱ
+		Deferred deferred; //ӳȾģʽµG-buffer͹
+		Clustered clustered; //ִǰȾģʽµĹԴ
+
+		bool batched; //Ƿʹ
+		Batch batch; //ʱ嶼
+
+		Culling culling; //޳ʽ
+		BoundSet bounds; //İΧ壬±һ
+		BVH bvh; //ĲΰΧ
+		bool bvh_dirty; //Ƿ¼壬Ҫ¹BVH
+		std::vector<unsigned> visible; //ǰpassпɼ
+		bool occlusion_culling; //Ƿڵ޳
+		OcclusionBuffer occlusion; //ڵ޳õĵͷֱȻ
+		bool hardware_occlusion; //ǷʹӲڵѯ
+		bool query_ready; //ڵѯprogramǷѾʼ
+		OcclusionQuery hw_query;
+		std::vector<unsigned> hidden, queried; //һ֡ס塢֡Ҫ²ѯĿɼ
+		bool camera_all; //passǷ壨δ޳
+
+		bool prepass; //pass֮ǰǷȻһ
+		GpuTimer camera_timer; //passGPUϵĺʱ
+		unsigned visible_num; //һ֡ɼ
 
 		World(int screen_width, int screen_height, Mode mode = Mode::NO_SHADOW)
-			:mode(mode), m_fail(false), camera_pos(glm::vec3(-0.3f, 0.0f, 0.0f)),
-			camera_front(glm::vec3(1.0f, 0.0f, 0.0f)), camera_up(glm::vec3(0.0f, 1.0f, 0.0f))
+			:mode(mode), m_fail(false), camera_pos(glm::vec3(-0.3f, 0.0f, 0.0f)), camera_front(glm::vec3(1.0f, 0.0f, 0.0f)), camera_up(glm::vec3(0.0f, 1.0f, 0.0f)),
+			cascade_draw_num{}, dynamic_num(0), static_dirty(true), dynamic_dirty(true), light_moved(false), shadow_light_pos(0.0f),
+			rsm_light(RsmLight::POINT), rsm_light_id(0), rsm_view(1.0f), rsm_scale(1.0f), face_static_num{}, face_dynamic_num{}, batched(false), culling(Culling::HIERARCHICAL), bvh_dirty(false), occlusion_culling(true),
+			hardware_occlusion(false), query_ready(false), camera_all(false),
+			prepass(mode == Mode::REFLECTIVE_SHADOW), visible_num(0)
 		{
 
 			if (mode == Mode::NORMAL_SHADOW) {
@@ -38,7 +113,6 @@ namespace illusion {
 				m_fail = vertex_shader.fail() || fragment_shader.fail() || light_vertex_shader.fail()
 					|| light_fragment_shader.fail() || !object_prog.link(vertex_shader, fragment_shader)
 					|| !light_prog.link(light_vertex_shader, light_fragment_shader);
-				depth = FrameBuffer(shadow_width, shadow_height, nullptr, GL_FLOAT);
 			} else if (mode == Mode::REFLECTIVE_SHADOW) {
 				Shader vertex_shader(GL_VERTEX_SHADER, "./shader/general_shadow.vs");
 				Shader fragment_shader(GL_FRAGMENT_SHADER, "./shader/object_rsm.fs");
@@ -48,6 +122,38 @@ namespace illusion {
 					|| light_fragment_shader.fail() || !object_prog.link(vertex_shader, fragment_shader)
 					|| !light_prog.link(light_vertex_shader, light_fragment_shader);
 				rsm_buf = FullFrameBuffer(shadow_width, shadow_height);
+				rsm_static = FullFrameBuffer(shadow_width, shadow_height);
+				rsm_flat = FlatFrameBuffer(shadow_width, shadow_height);
+				rsm_flat_static = FlatFrameBuffer(shadow_width, shadow_height);
+				object_prog.set("flat_depth_map", 4);
+				object_prog.set("rsm_flat", 0);
+			} else if (mode == Mode::LIGHT_PROPAGATION || mode == Mode::IRRADIANCE_PROBES || mode == Mode::VOXEL_CONE_TRACING) {
+				Shader vertex_shader(GL_VERTEX_SHADER, "./shader/general_shadow.vs");
+				Shader fragment_shader(GL_FRAGMENT_SHADER, mode == Mode::LIGHT_PROPAGATION ? "./shader/object_lpv.fs"
+					: mode == Mode::IRRADIANCE_PROBES ? "./shader/object_probe.fs" : "./shader/object_voxel.fs");
+				Shader light_vertex_shader(GL_VERTEX_SHADER, "./shader/general.vs");
+				Shader light_fragment_shader(GL_FRAGMENT_SHADER, "./shader/light.fs");
+				m_fail = vertex_shader.fail() || fragment_shader.fail() || light_vertex_shader.fail()
+					|| light_fragment_shader.fail() || !object_prog.link(vertex_shader, fragment_shader)
+					|| !light_prog.link(light_vertex_shader, light_fragment_shader);
+				rsm_buf = FullFrameBuffer(shadow_width, shadow_height);
+				rsm_static = FullFrameBuffer(shadow_width, shadow_height);
+			} else if (mode == Mode::DEFERRED) {
+				Shader vertex_shader(GL_VERTEX_SHADER, "./shader/general.vs");
+				Shader fragment_shader(GL_FRAGMENT_SHADER, "./shader/gbuffer.fs");
+				Shader light_vertex_shader(GL_VERTEX_SHADER, "./shader/general.vs");
+				Shader light_fragment_shader(GL_FRAGMENT_SHADER, "./shader/light.fs");
+				m_fail = vertex_shader.fail() || fragment_shader.fail() || light_vertex_shader.fail()
+					|| light_fragment_shader.fail() || !object_prog.link(vertex_shader, fragment_shader)
+					|| !light_prog.link(light_vertex_shader, light_fragment_shader);
+			} else if (mode == Mode::CLUSTERED) {
+				Shader vertex_shader(GL_VERTEX_SHADER, "./shader/general.vs");
+				Shader fragment_shader(GL_FRAGMENT_SHADER, "./shader/object_clustered.fs");
+				Shader light_vertex_shader(GL_VERTEX_SHADER, "./shader/general.vs");
+				Shader light_fragment_shader(GL_FRAGMENT_SHADER, "./shader/light.fs");
+				m_fail = vertex_shader.fail() || fragment_shader.fail() || light_vertex_shader.fail()
+					|| light_fragment_shader.fail() || !object_prog.link(vertex_shader, fragment_shader)
+					|| !light_prog.link(light_vertex_shader, light_fragment_shader);
 			} else {
 				Shader vertex_shader(GL_VERTEX_SHADER, "./shader/general.vs");
 				Shader fragment_shader(GL_FRAGMENT_SHADER, "./shader/object.fs");
@@ -59,32 +165,43 @@ namespace illusion {
 			}
 			
 			
-			glm::mat4 model = glm::mat4(1.0f),
-				projection = glm::perspective(glm::radians(45.0f), float(screen_width) / screen_height, 0.1f, 100.0f);
+			Shader depth_vs(GL_VERTEX_SHADER, "./shader/bound.vs");
+			Shader depth_fs(GL_FRAGMENT_SHADER, "./shader/bound.fs");
+			m_fail = m_fail || depth_vs.fail() || depth_fs.fail() || !depth_prog.link(depth_vs, depth_fs);
+
+			constexpr float camera_near = 0.1f, camera_far = 100.0f;
+			projection = glm::perspective(glm::radians(45.0f), float(screen_width) / screen_height, camera_near, camera_far);
 			object_prog.set("projection", projection);
-			object_prog.set("material.shininess", 32.0f);
-			object_prog.set("dir_light_num", 0);
-			object_prog.set("point_light_num", 0);
-			object_prog.set("spot_light_num", 0);
+			if (mode == Mode::DEFERRED) m_fail = m_fail || !deferred.init(screen_width, screen_height, projection);
+			else {
+				object_prog.set("material.shininess", 32.0f);
+				object_prog.set("dir_light_num", 0);
+				if (mode == Mode::CLUSTERED) clustered.init(object_prog, screen_width, screen_height, camera_near, camera_far, projection);
+				else {
+					object_prog.set("point_light_num", 0);
+					object_prog.set("spot_light_num", 0);
+				}
+			}
 			light_prog.set("projection", projection);
 			light_prog.set("light_color", glm::vec3(1, 1, 1));
+			depth_prog.set("projection", projection);
 			
-			if (mode == Mode::REFLECTIVE_SHADOW) {
+			if (rsm_mode()) {
 				Shader rsm_vs(GL_VERTEX_SHADER, "./shader/rsm.vs");
 				Shader rsm_fs(GL_FRAGMENT_SHADER, "./shader/rsm.fs");
-				Shader rsm_gs(GL_GEOMETRY_SHADER, "./shader/rsm.gs");
-				m_fail = m_fail || rsm_vs.fail() || rsm_gs.fail() || rsm_fs.fail() || !help_prog.link(rsm_vs, rsm_fs, rsm_gs);
-				object_prog.set("indirect_map", 13);
-				object_prog.set("normal_map", 12);
-				object_prog.set("pos_map", 11);
+				m_fail = m_fail || rsm_vs.fail() || rsm_fs.fail() || !help_prog.link(rsm_vs, rsm_fs);
 				object_prog.set("depth_map", 14);
+				if (mode == Mode::REFLECTIVE_SHADOW) m_fail = m_fail || !indirect_pass.init(screen_width, screen_height, projection, shadow_width);
+				else if (mode == Mode::LIGHT_PROPAGATION) m_fail = m_fail || !volume.init(object_prog, shadow_width, 12);
+				else if (mode == Mode::VOXEL_CONE_TRACING) m_fail = m_fail || !voxels.init(object_prog, 14, shadow_near, shadow_far);
+				else m_fail = m_fail || !probes.init(object_prog, "./probe_cache.bin");
 			} else if (mode == Mode::NORMAL_SHADOW) {
 				Shader depth_vs(GL_VERTEX_SHADER, "./shader/shadow.vs");
 				Shader depth_fs(GL_FRAGMENT_SHADER, "./shader/shadow.fs");
-				Shader depth_gs(GL_GEOMETRY_SHADER, "./shader/shadow.gs");
-				m_fail = m_fail || depth_fs.fail() || depth_vs.fail() || depth_gs.fail() || !help_prog.link(depth_vs, depth_fs, depth_gs);
-				object_prog.set("depth_map", 14);
-			}
+				m_fail = m_fail || depth_fs.fail() || depth_vs.fail() || !help_prog.link(depth_vs, depth_fs);
+				m_fail = m_fail || !shadows.init(object_prog, shadow_far);
+				m_fail = m_fail || !cascades.init(object_prog, projection, camera_near, cascade_distance);
+			} else if (mode == Mode::LIGHTMAP) m_fail = m_fail || !lightmap.init(object_prog, "./lightmap_cache.bin");
 		}
 
 		void process_input(GLFWwindow* window) {
@@ -121,6 +238,37 @@ namespace illusion {
 				std::cout << std::endl;
 				for (int i = 0; i < 3; ++i) std::cout << p.second[i] << ' ';
 				std::cout << std::endl;
+				std::cout << "visible: " << visible_num << '/' << bounds.size() << std::endl;
+				std::cout << "camera pass: " << camera_timer.average_ms() << "ms" << (prepass ? " (prepass)" : "") << std::endl;
+				if (mode == Mode::NORMAL_SHADOW) {
+					std::cout << "shadow lights updated: " << shadows.get_updated_num() << '/' << shadows.light_num()
+						<< ", casters drawn: " << shadows.get_draw_num() << ", " << shadows.get_ms() << "ms" << std::endl;
+					std::cout << "per light: cube " << shadows.get_light_ms(ShadowTechnique::CUBE) << "ms, paraboloid "
+						<< shadows.get_light_ms(ShadowTechnique::PARABOLOID) << "ms" << std::endl;
+					if (cascades.has_light()) {
+						std::cout << "cascades:";
+						for (int i = 0; i < cascades.get_cascade_num(); ++i) std::cout << ' ' << cascade_draw_num[i];
+						std::cout << std::endl;
+					}
+				}
+				if (rsm_mode()) {
+					std::cout << "shadow faces (static/dynamic):";
+					for (int i = 0; i < 6; ++i) std::cout << ' ' << face_static_num[i] << '/' << face_dynamic_num[i];
+					std::cout << std::endl;
+				}
+				if (mode == Mode::REFLECTIVE_SHADOW) {
+					std::cout << "indirect pass: " << indirect_timer.average_ms() << "ms" << std::endl;
+					std::cout << "vpls: " << indirect_pass.get_vpls().get_num() << ", clustering: " << indirect_pass.get_vpls().get_cpu_ms() << "ms" << std::endl;
+				}
+				if (mode == Mode::LIGHT_PROPAGATION) std::cout << "light volume update: " << indirect_timer.average_ms() << "ms" << std::endl;
+				//REFLECTIVE_SHADOWԱʱظ¶Ӧindirect passԲ׶׷ٰcamera pass
+				if (mode == Mode::VOXEL_CONE_TRACING) std::cout << "voxel update: " << indirect_timer.average_ms() << "ms ("
+					<< VoxelVolume::size << "^3, cone tracing in camera pass)" << std::endl;
+				if (mode == Mode::IRRADIANCE_PROBES) std::cout << "probe bake: " << probes.get_bake_ms() << "ms" << std::endl;
+				if (mode == Mode::LIGHTMAP) std::cout << "lightmap bake: " << lightmap.get_bake_ms() << "ms, charts: " << lightmap.chart_num()
+					<< ", texel: " << lightmap.get_texel_size() << std::endl;
+				if (mode == Mode::DEFERRED) std::cout << "lights: " << deferred.get_lit_num() << '/' << deferred.light_num() << std::endl;
+				if (mode == Mode::CLUSTERED) std::cout << "lights: " << clustered.light_num() << ", assigned: " << clustered.get_assigned_num() << std::endl;
 			}
 		}
 
@@ -155,6 +303,291 @@ namespace illusion {
 			));
 		}
 
+		//
+		void draw_objects(Program& prog) {
+			if (batched) batch.draw(prog);
+			else for (auto& it : objects) it.draw(prog);
+		}
+
+		//ֻvisibleе
+		void draw_visible(Program& prog) {
+			if (batched) batch.draw(prog, visible);
+			else for (unsigned id : visible) objects[id].draw(prog);
+		}
+
+		//һ
+		void draw_one(Program& prog, unsigned id) {
+			if (batched) batch.draw_one(prog, id);
+			else objects[id].draw(prog);
+		}
+
+		//ӲڵѯĿ»visibleе壬ͬʱ֡Ĳѯ
+		void draw_queried(Program& prog, const glm::mat4& view) {
+			hw_query.begin_frame(bounds.size());
+			hw_query.classify(visible, hidden, bounds, camera_pos);
+			//һ֡ɼֱӻƣ²ѯʱ嵥ƲΪѯ
+			queried.clear();
+			unsigned n = 0;
+			for (unsigned id : visible) {
+				if (hw_query.due(id)) queried.push_back(id);
+				else visible[n++] = id;
+			}
+			visible.resize(n);
+			draw_visible(prog);
+			for (unsigned id : queried) {
+				hw_query.begin(id);
+				draw_one(prog, id);
+				hw_query.end(id);
+			}
+			//һ֡סȲѯΧУGPUݲѯǷ
+			hw_query.query_boxes(hidden, bounds, view, projection);
+			for (unsigned id : hidden) {
+				hw_query.begin_conditional(id);
+				draw_one(prog, id);
+				hw_query.end_conditional();
+			}
+			visible_num = visible.size() + queried.size();
+		}
+
+		//draw_queriedֺõĽٻһ飬µĲѯ
+		void redraw_queried(Program& prog) {
+			draw_visible(prog);
+			for (unsigned id : queried) draw_one(prog, id);
+			for (unsigned id : hidden) {
+				hw_query.begin_conditional(id);
+				draw_one(prog, id);
+				hw_query.end_conditional();
+			}
+		}
+
+		//ɼ壬visible
+		void cull_camera(const glm::mat4& view) {
+			glm::mat4 view_projection = projection * view;
+			visible.clear();
+			camera_all = culling == Culling::NONE;
+			if (camera_all) {
+				for (unsigned i = 0; i < bounds.size(); ++i) visible.push_back(i);
+			} else {
+				if (culling == Culling::HIERARCHICAL) bvh.query(Frustum(view_projection), visible);
+				else bounds.cull(Frustum(view_projection), visible);
+				if (occlusion_culling && !occlusion.empty()) {
+					occlusion.render(view_projection);
+					visible.erase(std::remove_if(visible.begin(), visible.end(), [this](unsigned id) {
+						return !occlusion.visible(bounds.get(id));
+					}), visible.end());
+				}
+			}
+			visible_num = visible.size();
+		}
+
+		//cull_cameraõ壬firstʾǷΪ֡ĵһλ
+		void draw_camera(Program& prog, const glm::mat4& view, bool first) {
+			if (hardware_occlusion) {
+				if (first) draw_queried(prog, view);
+				else redraw_queried(prog);
+			} else if (camera_all) draw_objects(prog);
+			else draw_visible(prog);
+		}
+
+		enum class Layer { ALL, STATIC, DYNAMIC }; //ӰpassƵ
+
+		//ͼһ׶ڵ壬ӰpassػƵ
+		unsigned draw_light_face(Program& prog, const glm::mat4& face_matrix, Layer layer) {
+			if (culling == Culling::NONE && (layer == Layer::ALL || (layer == Layer::STATIC && !dynamic_num))) {
+				draw_objects(prog);
+				return bounds.size();
+			}
+			visible.clear();
+			if (culling == Culling::NONE) {
+				for (unsigned i = 0; i < bounds.size(); ++i) visible.push_back(i);
+			} else if (culling == Culling::HIERARCHICAL) bvh.query(Frustum(face_matrix), visible);
+			else bounds.cull(Frustum(face_matrix), visible);
+			if (layer != Layer::ALL) {
+				bool dynamic_layer = layer == Layer::DYNAMIC;
+				visible.erase(std::remove_if(visible.begin(), visible.end(), [this, dynamic_layer](unsigned id) {
+					return (dynamic[id] != 0) != dynamic_layer;
+				}), visible.end());
+			}
+			if (!visible.empty()) draw_visible(prog);
+			return visible.size();
+		}
+
+		//һཻ壬ÿֱ޳ȡɫٰ޳
+		unsigned draw_cascades(Program& prog, const glm::mat4* matrices, int num) {
+			if (culling == Culling::NONE) {
+				for (int i = 0; i < num; ++i) cascade_draw_num[i] = bounds.size();
+				draw_objects(prog);
+				return bounds.size();
+			}
+			visible.clear();
+			for (int i = 0; i < num; ++i) {
+				casters.clear();
+				if (culling == Culling::HIERARCHICAL) bvh.query(Frustum(matrices[i]), casters);
+				else bounds.cull(Frustum(matrices[i]), casters);
+				cascade_draw_num[i] = casters.size();
+				visible.insert(visible.end(), casters.begin(), casters.end());
+			}
+			std::sort(visible.begin(), visible.end());
+			visible.erase(std::unique(visible.begin(), visible.end()), visible.end());
+			if (!visible.empty()) draw_visible(prog);
+			return visible.size();
+		}
+
+		//ΧǷͶӰĹԴΧ
+		bool in_shadow_range(const AABB& box) const {
+			if (rsm_light == RsmLight::DIRECTIONAL) return true;
+			glm::vec3 d = glm::max(glm::max(box.min - shadow_light_pos, shadow_light_pos - box.max), glm::vec3(0.0f));
+			return glm::dot(d, d) <= shadow_far * shadow_far;
+		}
+
+		//ǷҪƵԴRSM
+		bool rsm_mode() const {
+			return mode == Mode::REFLECTIVE_SHADOW || mode == Mode::LIGHT_PROPAGATION || mode == Mode::IRRADIANCE_PROBES || mode == Mode::VOXEL_CONE_TRACING;
+		}
+
+		//ΧĲ⴫ݴȷǷΧ
+		AABB scene_bounds() const {
+			AABB ret;
+			for (unsigned i = 0; i < bounds.size(); ++i) ret.extend(bounds.get(i));
+			return ret;
+		}
+
+		//۹ƺƽй2D RSM۹øнǵ͸ͶӰƽйøͶӰ
+		void update_flat_light() {
+			glm::vec3 dir = glm::normalize(rsm_light == RsmLight::SPOT ? spot_light_info[rsm_light_id].dir : dir_light_info[0].dir);
+			glm::vec3 up = std::abs(dir.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+			glm::mat4 light_projection;
+			bool ortho = rsm_light == RsmLight::DIRECTIONAL;
+			if (!ortho) {
+				const SpotLight& light = spot_light_info[rsm_light_id];
+				float half = std::acos(light.outer_cut_off);
+				light_projection = glm::perspective(2.0f * half, 1.0f, shadow_near, shadow_far);
+				shadow_light_pos = light.pos;
+				rsm_scale = glm::vec2(std::tan(half));
+				help_prog.set("light.diffuse", light.diffuse);
+				help_prog.set("light.cut_off", light.cut_off);
+				help_prog.set("light.outer_cut_off", light.outer_cut_off);
+			} else {
+				AABB scene = scene_bounds();
+				glm::vec3 center = scene.empty() ? glm::vec3(0.0f) : scene.center();
+				float r = scene.empty() ? 1.0f : scene.radius();
+				light_projection = glm::ortho(-r, r, -r, r, 0.0f, 2.0f * r);
+				shadow_light_pos = center - dir * r;
+				rsm_scale = glm::vec2(r);
+				help_prog.set("light.diffuse", dir_light_info[0].diffuse);
+			}
+			rsm_view = glm::lookAt(shadow_light_pos, shadow_light_pos + dir, up);
+			shadow_matrices[0] = light_projection * rsm_view;
+			help_prog.set("light.type", ortho ? 2 : 1);
+			help_prog.set("light.pos", shadow_light_pos);
+			help_prog.set("light.dir", dir);
+			help_prog.set("rsm_view", rsm_view);
+			for (const Program* prog : { &object_prog, &indirect_pass.program() }) {
+				prog->set("rsm_flat", 1);
+				prog->set("rsm_matrix", shadow_matrices[0]);
+				prog->set("rsm_scale", rsm_scale);
+				prog->set("rsm_ortho", ortho ? 1 : 0);
+			}
+			object_prog.set("rsm_view", rsm_view);
+			indirect_pass.program().set("rsm_inv_view", glm::inverse(rsm_view));
+		}
+
+		//ݹԴλøͼľ󣬾۹ƺƽй2D RSMľ
+		void update_shadow_light() {
+			if (rsm_light != RsmLight::POINT) {
+				update_flat_light();
+				static_dirty = true;
+				light_moved = false;
+				return;
+			}
+			const glm::vec3& light_pos = shadow_light_pos;
+			glm::mat4 light_projection;
+			light_projection = glm::perspective(glm::radians(90.0f), float(shadow_width) / shadow_height, shadow_near, shadow_far);
+			shadow_matrices[0] = light_projection * glm::lookAt(light_pos, light_pos + glm::vec3(1, 0, 0), glm::vec3(0, -1, 0));
+			shadow_matrices[1] = light_projection * glm::lookAt(light_pos, light_pos + glm::vec3(-1, 0, 0), glm::vec3(0, -1, 0));
+			shadow_matrices[2] = light_projection * glm::lookAt(light_pos, light_pos + glm::vec3(0, 1, 0), glm::vec3(0, 0, 1));
+			shadow_matrices[3] = light_projection * glm::lookAt(light_pos, light_pos + glm::vec3(0, -1, 0), glm::vec3(0, 0, -1));
+			shadow_matrices[4] = light_projection * glm::lookAt(light_pos, light_pos + glm::vec3(0, 0, 1), glm::vec3(0, -1, 0));
+			shadow_matrices[5] = light_projection * glm::lookAt(light_pos, light_pos + glm::vec3(0, 0, -1), glm::vec3(0, -1, 0));
+			help_prog.set("light.type", 0);
+			help_prog.set("light.pos", light_pos);
+			if (!point_light_info.empty()) {
+				const PointLight& light = point_light_info[0];
+				help_prog.set("light.diffuse", light.diffuse);
+				help_prog.set("light.constant", light.constant);
+				help_prog.set("light.linear", light.linear);
+				help_prog.set("light.quadratic", light.quadratic);
+			}
+			if (mode == Mode::REFLECTIVE_SHADOW) {
+				indirect_pass.program().set("light_pos", light_pos);
+				indirect_pass.program().set("rsm_flat", 0);
+				object_prog.set("rsm_flat", 0);
+			}
+			static_dirty = true;
+			light_moved = false;
+		}
+
+		//Ӱ沢󶨵Ԫϣstatic_bufbufֱΪ̬ͺϳɽذ󶨵ĻǷ»ƹ
+		template<typename T>
+		bool update_shadow(T& static_buf, T& buf, int unit, GLbitfield clear_mask, int face_num = 6) {
+			if (!static_dirty && !(dynamic_num && dynamic_dirty)) {
+				if (dynamic_num) buf.bind(unit);
+				else static_buf.bind(unit);
+				return false;
+			}
+			//ƣÿֻ׶ཻ壬бƫȼӰ
+			glViewport(0, 0, shadow_width, shadow_height);
+			glEnable(GL_POLYGON_OFFSET_FILL);
+			glPolygonOffset(1.5f, 4.0f);
+			if (static_dirty) {
+				for (int i = 0; i < face_num; ++i) {
+					static_buf.use_face(i);
+					glClear(clear_mask);
+					help_prog.set("face_matrix", shadow_matrices[i]);
+					face_static_num[i] = draw_light_face(help_prog, shadow_matrices[i], Layer::STATIC);
+				}
+				static_dirty = false;
+				dynamic_dirty = true;
+			}
+			if (dynamic_num) {
+				buf.copy_from(static_buf, shadow_width, shadow_height);
+				for (int i = 0; i < face_num; ++i) {
+					buf.use_face(i);
+					help_prog.set("face_matrix", shadow_matrices[i]);
+					face_dynamic_num[i] = draw_light_face(help_prog, shadow_matrices[i], Layer::DYNAMIC);
+				}
+				dynamic_dirty = false;
+				buf.generate_mipmap();
+				buf.bind(unit);
+			} else {
+				static_buf.generate_mipmap();
+				static_buf.bind(unit);
+			}
+			glDisable(GL_POLYGON_OFFSET_FILL);
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			glViewport(0, 0, width, height);
+			return true;
+		}
+
+		//һ
+		void add_object(const std::vector<Vertex>& vertices, const std::vector<unsigned>& indices,
+						Texture* diffuse, Texture* specular, const glm::mat4& model) {
+			if (batched) batch.add(vertices, indices, diffuse, specular, model);
+			else if (mode == Mode::LIGHTMAP) {
+				//ͼchartֶٴmesh
+				std::vector<Vertex> split_vertices;
+				std::vector<unsigned> split_indices;
+				lightmap.add(vertices, indices, model, diffuse ? diffuse->average_color() : glm::vec3(1.0f), split_vertices, split_indices);
+				objects.emplace_back(Mesh(split_vertices, split_indices, diffuse, specular, model));
+			} else objects.emplace_back(Mesh(vertices, indices, diffuse, specular, model));
+			if (mode == Mode::IRRADIANCE_PROBES) probes.add(vertices, indices, model, diffuse ? diffuse->average_color() : glm::vec3(1.0f));
+			bounds.add(Mesh::calc_bound(vertices, model));
+			shadows.invalidate(bounds.get(bounds.size() - 1));
+			dynamic.push_back(0);
+			bvh_dirty = true;
+			static_dirty = true;
+		}
+
 		//·texture
 		Texture* build_texture(const char* name) {
 			std::string str(name);
@@ -169,6 +602,8 @@ namespace illusion {
 	public:
 		static constexpr int width = 800, height = 600;
 		static constexpr int shadow_width = 512, shadow_height = 512;
+		static constexpr float shadow_near = 0.1f, shadow_far = 25.0f; //ӰͼĽƽԶƽ棬Զƽ漴ͶӰķΧ
+		static constexpr float cascade_distance = 50.0f; //ƽйӰǵԶ
 		static World& instance(Mode mode = Mode::NO_SHADOW) { static World w(width, height, mode); return w; }
 
 		void set_camera(const glm::vec3& from, const glm::vec3& lookat) {
@@ -180,59 +615,240 @@ namespace illusion {
 			return std::make_pair(camera_pos, camera_pos + camera_front);
 		}
 
+		//ƣϲͬһ׻УÿpassʸһΣҪڼǰ
+		void set_batched(bool value) {
+			if (!objects.empty() || batch.size()) std::cerr << "ERROR::WORLD::SET_BATCHED_AFTER_BUILD" << std::endl;
+			else if (value && mode == Mode::LIGHTMAP) std::cerr << "ERROR::WORLD::LIGHTMAP_BATCHED_UNSUPPORTED" << std::endl;
+			else batched = value;
+		}
+
+		//޳ʽ
+		void set_culling(Culling value) { culling = value; }
+
+		//رڵ޳ֻpassЧ
+		void set_occlusion_culling(bool value) { occlusion_culling = value; }
+
+		//رԤpassĬֻƬɫܴREFLECTIVE_SHADOWģʽ¿
+		void set_depth_prepass(bool value) { prepass = value; }
+
+		//رӲڵѯֻpassЧ
+		void set_hardware_occlusion(bool value) {
+			if (value && !query_ready) query_ready = hw_query.init();
+			hardware_occlusion = value && query_ready;
+		}
+
+		//RSMӹԤ裬ֻREFLECTIVE_SHADOWģʽЧ
+		void set_indirect_quality(IndirectQuality quality) {
+			if (mode == Mode::REFLECTIVE_SHADOW) indirect_pass.set_quality(quality);
+		}
+
+		//رRSMӹʱۻĬϿ
+		void set_indirect_temporal(bool value) {
+			if (mode == Mode::REFLECTIVE_SHADOW) indirect_pass.set_temporal(value);
+		}
+
+		//ѡRSMĹԴidΪ۹Ƽ˳򣬵Դ̶Ϊ0ֻREFLECTIVE_SHADOWģʽЧ
+		//۹ƺƽйֻһ2D RSMοԼΪRSM1/6Ҳֻ2Dȡ
+		void set_rsm_light(RsmLight type, unsigned id = 0) {
+			bool valid = type == RsmLight::POINT ? !point_light_pos.empty()
+				: type == RsmLight::SPOT ? id < spot_light_info.size() : !dir_light_info.empty();
+			if (mode != Mode::REFLECTIVE_SHADOW || !valid) {
+				std::cerr << "ERROR::WORLD::RSM_LIGHT_UNSUPPORTED" << std::endl;
+				return;
+			}
+			rsm_light = type;
+			rsm_light_id = type == RsmLight::SPOT ? id : 0;
+			//2D RSMֻƵ0棬RSMͳ
+			for (int i = 1; i < 6; ++i) face_static_num[i] = face_dynamic_num[i] = 0;
+			if (type == RsmLight::POINT) shadow_light_pos = point_light_pos[0];
+			light_moved = true;
+		}
+
+		//Իº決ն̽룬ֻIRRADIANCE_PROBESģʽЧ
+		void rebake_probes() {
+			if (mode != Mode::IRRADIANCE_PROBES) return;
+			probes.set_lights(point_light_info, spot_light_info, dir_light_info);
+			probes.rebake();
+		}
+
+		//Ի棬ǰλú͹Դº決ͼֻLIGHTMAPģʽЧ
+		void rebake_lightmap() {
+			if (mode != Mode::LIGHTMAP) return;
+			lightmap.set_lights(point_light_info, spot_light_info, dir_light_info);
+			lightmap.rebake();
+		}
+
+		//ôRSMVPL640ʾʹصԲֻ̲REFLECTIVE_SHADOWģʽЧ
+		void set_indirect_vpl_num(int num) {
+			if (mode == Mode::REFLECTIVE_SHADOW) indirect_pass.set_vpl_num(num);
+		}
+
+		//õԴӰĻƷʽidΪԴ˳ֻNORMAL_SHADOWģʽЧ
+		void set_shadow_technique(unsigned id, ShadowTechnique technique) { shadows.set_technique(id, technique); }
+
+		//ÿ֡µԴӰGPUʱԤ㣨룩ֻNORMAL_SHADOWģʽЧ
+		void set_shadow_budget(float ms) { shadows.set_budget(ms); }
+
+		//ɼ½ڵѯļ֡
+		void set_query_interval(unsigned frames) { hw_query.set_interval(frames); }
+
+		//޸ı任idΪ˳ƶ֮Ϊ̬Ӱ
+		void transform_object(unsigned id, const glm::mat4& model) {
+			bool in_range = in_shadow_range(bounds.get(id));
+			shadows.invalidate(bounds.get(id));
+			AABB box;
+			if (batched) {
+				batch.set_model(id, model);
+				box = batch.get_bound(id);
+			} else {
+				objects[id].set_model(model);
+				box = objects[id].get_bound();
+				if (mode == Mode::LIGHTMAP) lightmap.set_model(id, model);
+			}
+			if (mode == Mode::VOXEL_CONE_TRACING) voxels.invalidate();
+			bounds.set(id, box);
+			if (!bvh_dirty) bvh.refit(id, box);
+			shadows.invalidate(box);
+			in_range = in_range || in_shadow_range(box);
+			if (!dynamic[id]) {
+				dynamic[id] = 1;
+				++dynamic_num;
+				if (in_range) static_dirty = true;
+			}
+			if (in_range) dynamic_dirty = true;
+		}
+
+		//ƶԴֻǰȾģʽЧ
+		void move_point_light(unsigned id, const glm::vec3& pos) {
+			if (mode == Mode::DEFERRED || mode == Mode::CLUSTERED || id >= point_light_pos.size()) {
+				std::cerr << "ERROR::WORLD::MOVE_LIGHT_UNSUPPORTED" << std::endl;
+				return;
+			}
+			std::string name = "point_lights[" + std::to_string(id) + "].pos";
+			object_prog.set(name.c_str(), pos);
+			point_lights[id].set_model(glm::translate(glm::mat4(1.0f), pos - point_light_pos[id]) * point_lights[id].get_model());
+			point_light_pos[id] = pos;
+			point_light_info[id].pos = pos;
+			if (mode == Mode::NORMAL_SHADOW) shadows.move_light(id, pos);
+			else if (id == 0 && rsm_light == RsmLight::POINT) {
+				shadow_light_pos = pos;
+				light_moved = true;
+			}
+		}
+
+		//һ֡ɼ
+		unsigned get_visible_num() const { return visible_num; }
+
 		void mainloop(GLFWwindow* window, int times = -1) {
 			glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 			if (times < 0) glfwSetCursorPosCallback(window, mouse_callback);
+			if (batched) batch.upload();
 			
-			if (mode == Mode::NORMAL_SHADOW || mode == Mode::REFLECTIVE_SHADOW) {
-				glm::vec3 light_pos = object_prog.get<glm::vec3>("point_lights[0].pos");
-				glm::mat4 light_projection;
-				glm::mat4 shadow_matrices[6];
-				constexpr float far_plane = 25.0f;
-				light_projection = glm::perspective(glm::radians(90.0f), float(shadow_width) / shadow_height, 0.1f, far_plane);
-				shadow_matrices[0] = light_projection * glm::lookAt(light_pos, light_pos + glm::vec3(1, 0, 0), glm::vec3(0, -1, 0));
-				shadow_matrices[1] = light_projection * glm::lookAt(light_pos, light_pos + glm::vec3(-1, 0, 0), glm::vec3(0, -1, 0));
-				shadow_matrices[2] = light_projection * glm::lookAt(light_pos, light_pos + glm::vec3(0, 1, 0), glm::vec3(0, 0, 1));
-				shadow_matrices[3] = light_projection * glm::lookAt(light_pos, light_pos + glm::vec3(0, -1, 0), glm::vec3(0, 0, -1));
-				shadow_matrices[4] = light_projection * glm::lookAt(light_pos, light_pos + glm::vec3(0, 0, 1), glm::vec3(0, -1, 0));
-				shadow_matrices[5] = light_projection * glm::lookAt(light_pos, light_pos + glm::vec3(0, 0, -1), glm::vec3(0, -1, 0));
-				for (int i = 0; i < 6; ++i) {
-					std::string str = ("shadow_matrices[" + std::to_string(i) + "]");
-					help_prog.set(str.c_str(), shadow_matrices[i]);
-				}
-				help_prog.set("far_plane", far_plane);
-				object_prog.set("far_plane", far_plane);
-				help_prog.set("light.pos", light_pos);
+			if (mode == Mode::NORMAL_SHADOW || rsm_mode()) {
+				object_prog.set("far_plane", shadow_far);
+				object_prog.set("shadow_near", shadow_near);
 			}
+			if (rsm_mode()) update_shadow_light();
+			if (mode == Mode::LIGHTMAP) lightmap.set_lights(point_light_info, spot_light_info, dir_light_info);
+			if (mode == Mode::IRRADIANCE_PROBES) probes.set_lights(point_light_info, spot_light_info, dir_light_info);
 			
 			while (!glfwWindowShouldClose(window)) {
 				process_input(window);
+				if (bvh_dirty) {
+					bvh.build(bounds);
+					//⴫ֻʱķΧƶٵ
+					if (mode == Mode::LIGHT_PROPAGATION) volume.set_bounds(object_prog, scene_bounds());
+					if (mode == Mode::VOXEL_CONE_TRACING) voxels.set_bounds(object_prog, scene_bounds());
+					if (mode == Mode::IRRADIANCE_PROBES) probes.set_bounds(object_prog, scene_bounds());
+					//ƽйͶӰҪµĳΧ
+					if (rsm_light == RsmLight::DIRECTIONAL) light_moved = true;
+					bvh_dirty = false;
+				}
 				
 				if (times) {
+					glm::mat4 view = glm::lookAt(camera_pos, camera_pos + camera_front, camera_up);
 					if (mode == Mode::NORMAL_SHADOW) {
-						glViewport(0, 0, shadow_width, shadow_height);
-						depth.use(14);
-						glClear(GL_DEPTH_BUFFER_BIT);
-						for (auto& it : objects) it.draw(help_prog);
-						glBindFramebuffer(GL_FRAMEBUFFER, 0);
+						cascades.update(object_prog, view, [this](Program& prog, const glm::mat4* matrices, int num) {
+							return draw_cascades(prog, matrices, num);
+						});
+						shadows.update(help_prog, object_prog, view, projection, height, [this](Program& prog, const glm::mat4& face_matrix) {
+							return draw_light_face(prog, face_matrix, Layer::ALL);
+						});
 						glViewport(0, 0, width, height);
 						glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-					} else if (mode == Mode::REFLECTIVE_SHADOW) {
-						glViewport(0, 0, shadow_width, shadow_height);
-						rsm_buf.use(11);
-						glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-						for (auto& it : objects) it.draw(help_prog);
-						glBindFramebuffer(GL_FRAMEBUFFER, 0);
-						glViewport(0, 0, width, height);
+					} else if (rsm_mode()) {
+						if (light_moved) update_shadow_light();
+						if (rsm_light != RsmLight::POINT) {
+							if (update_shadow(rsm_flat_static, rsm_flat, 2, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT, 1))
+								indirect_pass.request_vpls(dynamic_num ? rsm_flat : rsm_flat_static, glm::inverse(rsm_view), rsm_scale, rsm_light == RsmLight::DIRECTIONAL);
+						} else if (update_shadow(rsm_static, rsm_buf, 12, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT)) {
+							if (mode == Mode::REFLECTIVE_SHADOW) indirect_pass.request_vpls(dynamic_num ? rsm_buf : rsm_static, shadow_light_pos);
+							else if (mode == Mode::VOXEL_CONE_TRACING) voxels.invalidate();
+							else volume.invalidate();
+						}
+						if (mode == Mode::LIGHT_PROPAGATION) {
+							//ֻRSM»ƺעʹ
+							indirect_timer.begin();
+							volume.update(shadow_light_pos);
+							indirect_timer.end();
+							glViewport(0, 0, width, height);
+						}
+						if (mode == Mode::VOXEL_CONE_TRACING && !point_light_info.empty()) {
+							//ֻƶRSM»ƺػע
+							PointLight light = point_light_info[0];
+							light.pos = shadow_light_pos;
+							indirect_timer.begin();
+							voxels.update(light, [this](Program& prog) { draw_objects(prog); });
+							indirect_timer.end();
+							glViewport(0, 0, width, height);
+						}
+						//ֻ̽ڵһʹûҪº決ʱȡ決֮ԴƶԶ
+						if (mode == Mode::IRRADIANCE_PROBES && probes.prepare(object_prog, shadow_light_pos, [this](Program& prog) { draw_objects(prog); })) {
+							object_prog.set("projection", projection);
+							glViewport(0, 0, width, height);
+						}
 						glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+					} else if (mode == Mode::DEFERRED) {
+						deferred.begin_geometry();
 					} else {
+						//ͼֻڵһʹûҪº決ʱȡ決͹Դ֮ƶԶ
+						if (mode == Mode::LIGHTMAP) lightmap.prepare([this](unsigned id, const std::vector<glm::vec2>& coords) {
+							objects[id].set_lightmap_coords(coords);
+						});
 						glClearColor(0.3f, 0.3f, 0.3f, 1.0f);
 						glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 					}
 
-					object_prog.set("view", glm::lookAt(camera_pos, camera_pos + camera_front, camera_up));
+					if (mode == Mode::CLUSTERED) clustered.update(view);
+					cull_camera(view);
+					if (mode == Mode::REFLECTIVE_SHADOW) {
+						//ӹڵͷֱ¼һΣڵѯĽʱûлֱ֣ӻ׶ڵ
+						indirect_timer.begin();
+						indirect_pass.begin(view);
+						if (camera_all) draw_objects(indirect_pass.program());
+						else draw_visible(indirect_pass.program());
+						indirect_pass.end(object_prog, view);
+						indirect_timer.end();
+					}
+					camera_timer.begin();
+					if (prepass) {
+						//ֻдȣ֮ɫpassÿֻƬͨȲ
+						depth_prog.set("view", view);
+						glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+						draw_camera(depth_prog, view, true);
+						glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+						glDepthMask(GL_FALSE);
+						glDepthFunc(GL_LEQUAL);
+					}
+					object_prog.set("view", view);
 					object_prog.set("view_pos", camera_pos);
-					for (auto& it : objects) it.draw(object_prog);
+					draw_camera(object_prog, view, !prepass);
+					if (prepass) {
+						glDepthMask(GL_TRUE);
+						glDepthFunc(GL_LESS);
+					}
+					camera_timer.end();
+					if (mode == Mode::DEFERRED) deferred.shade(view, camera_pos, Frustum(projection * view), glm::vec3(0.3f, 0.3f, 0.3f));
 
 					light_prog.set("view", glm::lookAt(camera_pos, camera_pos + camera_front, camera_up));
 					for (auto& it : point_lights) it.draw(light_prog);
@@ -249,9 +865,9 @@ namespace illusion {
 		template<typename T>
 		void build_object(T&& builder) {
 			builder.build();
-			objects.emplace_back(Mesh(builder.vertices, builder.indices,
-									  build_texture(builder.diffuse), build_texture(builder.specular),
-									  builder.model));
+			add_object(builder.vertices, builder.indices,
+					   build_texture(builder.diffuse), build_texture(builder.specular), builder.model);
+			if (builder.occluder) occlusion.add_occluder(builder.vertices, builder.indices, builder.model);
 		}
 
 		//builderԴ
@@ -260,6 +876,17 @@ namespace illusion {
 			builder.build();
 			std::string prefix = "point_lights[" + std::to_string(point_lights.size()) + "].";
 			point_lights.emplace_back(Mesh(builder.vertices, builder.indices, nullptr, nullptr, builder.model));
+			point_light_pos.push_back(light.pos);
+			point_light_info.push_back(light);
+			if (point_light_pos.size() == 1 && rsm_light == RsmLight::POINT) shadow_light_pos = light.pos;
+			if (mode == Mode::DEFERRED) {
+				deferred.add_point_light(light);
+				return;
+			}
+			if (mode == Mode::CLUSTERED) {
+				clustered.add_point_light(light);
+				return;
+			}
 			object_prog.set((prefix + "pos").c_str(), light.pos);
 			object_prog.set((prefix + "ambient").c_str(), light.ambient);
 			object_prog.set((prefix + "diffuse").c_str(), light.diffuse);
@@ -268,12 +895,7 @@ namespace illusion {
 			object_prog.set((prefix + "linear").c_str(), light.linear);
 			object_prog.set((prefix + "quadratic").c_str(), light.quadratic);
 			object_prog.set("point_light_num", (int)point_lights.size());
-			if (mode == Mode::REFLECTIVE_SHADOW) {
-				help_prog.set("light.diffuse", light.diffuse);
-				help_prog.set("light.constant", light.constant);
-				help_prog.set("light.linear", light.linear);
-				help_prog.set("light.quadratic", light.quadratic);
-			}
+			if (mode == Mode::NORMAL_SHADOW) shadows.add_light(object_prog, light);
 		}
 
 		//builder۹
@@ -282,6 +904,15 @@ namespace illusion {
 			builder.build();
 			std::string prefix = "spot_lights[" + std::to_string(spot_lights.size()) + "].";
 			spot_lights.emplace_back(Mesh(builder.vertices, builder.indices, nullptr, nullptr, builder.model));
+			spot_light_info.push_back(light);
+			if (mode == Mode::DEFERRED) {
+				deferred.add_spot_light(light);
+				return;
+			}
+			if (mode == Mode::CLUSTERED) {
+				clustered.add_spot_light(light);
+				return;
+			}
 			object_prog.set((prefix + "pos").c_str(), light.pos);
 			object_prog.set((prefix + "dir").c_str(), light.dir);
 			object_prog.set((prefix + "ambient").c_str(), light.ambient);
@@ -292,8 +923,14 @@ namespace illusion {
 			object_prog.set("spot_light_num", (int)spot_lights.size());
 		}
 
-		//ƽй
+		//ƽй⣬NORMAL_SHADOWģʽ²Ӱ
 		void build_dir_light(const DirLight& light) {
+			dir_light_info.assign(1, light);
+			if (mode == Mode::DEFERRED) {
+				deferred.add_dir_light(light);
+				return;
+			}
+			if (mode == Mode::NORMAL_SHADOW) cascades.set_light(object_prog, light);
 			object_prog.set("dir_light.dir", light.dir);
 			object_prog.set("dir_light.ambient", light.ambient);
 			object_prog.set("dir_light.diffuse", light.diffuse);
@@ -351,9 +988,9 @@ namespace illusion {
 							specular = spec.C_Str();
 						}
 					}
-					objects.emplace_back(Mesh(vertices, indices, 
-											  diffuse ? build_texture(diffuse) : nullptr, 
-											  specular ? build_texture(specular) : nullptr, model));
+					add_object(vertices, indices,
+							   diffuse ? build_texture(diffuse) : nullptr,
+							   specular ? build_texture(specular) : nullptr, model);
 				}
 				for (unsigned i = 0; i < node->mNumChildren; ++i) q.push(node->mChildren[i]);
 				q.pop();
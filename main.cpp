@@ -42,10 +42,13 @@ int main() {
 	glViewport(0, 0, screen_width, screen_height);
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 	
-	//
+	//磬World::Mode::VOXEL_CONE_TRACINGͬһ¶ԱԲ׶׷٣Pߵĺʱ
 	World& w = World::instance(World::Mode::REFLECTIVE_SHADOW);
 	if (w.fail()) return -1;
 
+	//ϲͬһ׻
+	w.set_batched(true);
+
 	//w.set_camera(glm::vec3(0.955841, 0.52701, 0.284357), glm::vec3(-0.0140141, 0.326787, 0.145462));
 
 	//ԭ㴴ģ
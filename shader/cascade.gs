@@ -0,0 +1,28 @@
+#version 330 core
+layout (triangles) in;
+layout (triangle_strip, max_vertices=12) out;
+
+#define MAX_CASCADE_NUM 4
+
+uniform mat4 cascade_matrices[MAX_CASCADE_NUM];
+uniform int cascade_num;
+
+// emit each triangle only to the cascades it overlaps; skip it when it lies fully outside one clip plane
+void main() {
+    for (int i = 0; i < cascade_num; ++i) {
+        vec4 p[3];
+        vec3 lo = vec3(1e30), hi = vec3(-1e30);
+        for (int j = 0; j < 3; ++j) {
+            p[j] = cascade_matrices[i] * gl_in[j].gl_Position;
+            lo = min(lo, p[j].xyz);
+            hi = max(hi, p[j].xyz);
+        }
+        if (any(greaterThan(lo, vec3(1.0))) || any(lessThan(hi, vec3(-1.0)))) continue;
+        for (int j = 0; j < 3; ++j) {
+            gl_Layer = i;
+            gl_Position = p[j];
+            EmitVertex();
+        }
+        EndPrimitive();
+    }
+}
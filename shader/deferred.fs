@@ -0,0 +1,71 @@
+#version 330 core
+
+struct Light {
+    vec3 pos;
+    vec3 dir;
+    float constant;
+    float linear;
+    float quadratic;
+    float cut_off;
+    float outer_cut_off;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+#define DIR_LIGHT 0
+#define POINT_LIGHT 1
+#define SPOT_LIGHT 2
+
+out vec4 o_color;
+
+uniform sampler2D albedo_map;
+uniform sampler2D specular_map;
+uniform sampler2D normal_map;
+
+uniform Light light;
+uniform int light_type;
+uniform float shininess;
+uniform vec3 view_pos;
+uniform mat4 inv_view;
+uniform vec2 screen_size;
+uniform vec2 tan_half_fov; //tangent of the half field of view along x and y
+
+void main() {
+    vec2 uv = gl_FragCoord.xy / screen_size;
+    vec4 normal_depth = texture(normal_map, uv);
+    if (normal_depth.w <= 0.0) discard;
+
+    //reconstruct the world space position from linear depth
+    vec3 view_space = vec3((uv * 2.0 - 1.0) * tan_half_fov * normal_depth.w, -normal_depth.w);
+    vec3 frag_pos = vec3(inv_view * vec4(view_space, 1.0));
+    vec3 normal = normalize(normal_depth.xyz);
+    vec3 view_dir = normalize(view_pos - frag_pos);
+    vec3 albedo = texture(albedo_map, uv).rgb;
+    vec3 spec_color = texture(specular_map, uv).rgb;
+
+    vec3 light_dir = light_type == DIR_LIGHT ? normalize(-light.dir) : normalize(light.pos - frag_pos);
+    float diff = max(dot(normal, light_dir), 0.0);
+    vec3 reflect_dir = reflect(-light_dir, normal);
+    float spec = pow(max(dot(view_dir, reflect_dir), 0.0), shininess);
+
+    vec3 ambient  = light.ambient  * albedo;
+    vec3 diffuse  = light.diffuse  * diff * albedo;
+    vec3 specular = light.specular * spec * spec_color;
+
+    if (light_type == POINT_LIGHT) {
+        float distance    = length(light.pos - frag_pos);
+        float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+        ambient  *= attenuation;
+        diffuse  *= attenuation;
+        specular *= attenuation;
+    } else if (light_type == SPOT_LIGHT) {
+        float theta = dot(light_dir, normalize(-light.dir));
+        float epsilon   = light.cut_off - light.outer_cut_off;
+        float intensity = clamp((theta - light.outer_cut_off) / epsilon, 0.0, 1.0);
+        diffuse  *= intensity;
+        specular *= intensity;
+    }
+
+    o_color = vec4(ambient + diffuse + specular, 1.0);
+}
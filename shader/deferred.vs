@@ -0,0 +1,15 @@
+#version 330 core
+layout (location = 0) in vec3 v_pos;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform bool full_screen;
+
+void main() {
+    if (full_screen) {
+        //full screen triangle, no vertex data needed
+        vec2 p = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+        gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);
+    } else gl_Position = projection * view * model * vec4(v_pos, 1.0);
+}
@@ -0,0 +1,24 @@
+#version 330 core
+
+struct Material {
+    sampler2D diffuse;
+    sampler2D specular;
+};
+
+layout (location = 0) out vec4 o_albedo;
+layout (location = 1) out vec4 o_specular;
+layout (location = 2) out vec4 o_normal;
+
+in vec3 f_normal;
+in vec3 f_pos;
+in vec2 f_coords;
+
+uniform Material material;
+uniform mat4 view;
+
+void main() {
+    o_albedo = vec4(texture(material.diffuse, f_coords).rgb, 1.0);
+    o_specular = vec4(texture(material.specular, f_coords).rgb, 1.0);
+    //w holds the linear view space depth, 0 means no geometry
+    o_normal = vec4(normalize(f_normal), -(view * vec4(f_pos, 1.0)).z);
+}
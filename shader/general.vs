@@ -2,10 +2,12 @@
 layout (location = 0) in vec3 v_pos;
 layout (location = 1) in vec3 v_normal;
 layout (location = 2) in vec2 v_coords;
+layout (location = 3) in vec2 v_lightmap_coords;
 
 out vec3 f_normal;
 out vec3 f_pos;
 out vec2 f_coords;
+out vec2 f_lightmap_coords;
 
 uniform mat4 model;
 uniform mat4 view;
@@ -16,4 +18,5 @@ void main() {
     gl_Position = projection * view * model * vec4(v_pos, 1.0);
 	f_normal = transpose(inverse(mat3(model))) * v_normal;
 	f_coords = v_coords;
+	f_lightmap_coords = v_lightmap_coords;
 }
@@ -0,0 +1,27 @@
+#version 330 core
+
+// the first 3 outputs are the L1 SH coefficients of R, G and B, the last 3 also add them to the accumulated result
+layout (location = 0) out vec4 o_r;
+layout (location = 1) out vec4 o_g;
+layout (location = 2) out vec4 o_b;
+layout (location = 3) out vec4 o_sum_r;
+layout (location = 4) out vec4 o_sum_g;
+layout (location = 5) out vec4 o_sum_b;
+
+in vec3 f_normal;
+in vec3 f_flux;
+
+const float PI = 3.14159265;
+
+// L1 SH coefficients of a cosine lobe around n, integrating to PI
+vec4 sh_cosine_lobe(vec3 n) {
+	return vec4(0.886226925, -1.02332671 * n.y, 1.02332671 * n.z, -1.02332671 * n.x);
+}
+
+// flux reflected by a diffuse surface leaves its front side with a cosine distribution
+void main() {
+	vec4 lobe = sh_cosine_lobe(f_normal) / PI;
+	o_r = o_sum_r = lobe * f_flux.r;
+	o_g = o_sum_g = lobe * f_flux.g;
+	o_b = o_sum_b = lobe * f_flux.b;
+}
@@ -0,0 +1,24 @@
+#version 330 core
+layout (points) in;
+layout (points, max_vertices=1) out;
+
+uniform int volume_size;
+
+flat in ivec3 g_cell[];
+in vec3 g_normal[];
+in vec3 g_flux[];
+
+out vec3 f_normal;
+out vec3 f_flux;
+
+// route the point to the layer and pixel of its cell; skip points outside the grid or without flux
+void main() {
+    ivec3 c = g_cell[0];
+    if (any(lessThan(c, ivec3(0))) || any(greaterThanEqual(c, ivec3(volume_size))) || g_flux[0] == vec3(0)) return;
+    gl_Layer = c.z;
+    gl_Position = vec4((vec2(c.xy) + 0.5) / float(volume_size) * 2.0 - 1.0, 0.0, 1.0);
+    f_normal = g_normal[0];
+    f_flux = g_flux[0];
+    EmitVertex();
+    EndPrimitive();
+}
@@ -0,0 +1,46 @@
+#version 330 core
+
+uniform samplerCube geometry_map; //xy: octahedron encoded normal, z: distance to the light
+uniform samplerCube flux_map;
+uniform float rsm_level; //RSM mip level to read
+uniform int rsm_face; //face resolution of that level
+uniform vec3 light_pos;
+uniform vec3 volume_min;
+uniform float volume_cell;
+uniform float flux_scale;
+
+flat out ivec3 g_cell;
+out vec3 g_normal;
+out vec3 g_flux;
+
+// direction through (s, t) on the given cube map face
+vec3 cube_dir(int face, vec2 st) {
+	vec2 c = st * 2.0 - 1.0;
+	if (face == 0) return vec3(1.0, -c.y, -c.x);
+	if (face == 1) return vec3(-1.0, -c.y, c.x);
+	if (face == 2) return vec3(c.x, 1.0, c.y);
+	if (face == 3) return vec3(c.x, -1.0, -c.y);
+	if (face == 4) return vec3(c.x, -c.y, 1.0);
+	return vec3(-c.x, -c.y, -1.0);
+}
+
+vec3 oct_decode(vec2 p) {
+	vec3 n = vec3(p, 1.0 - abs(p.x) - abs(p.y));
+	if (n.z < 0.0) n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	return normalize(n);
+}
+
+// one vertex per RSM texel
+void main() {
+	int face_texels = rsm_face * rsm_face;
+	int face = gl_VertexID / face_texels, texel = gl_VertexID % face_texels;
+	vec2 st = (vec2(texel % rsm_face, texel / rsm_face) + 0.5) / float(rsm_face);
+	vec3 dir = normalize(cube_dir(face, st));
+	vec4 geometry = textureLod(geometry_map, dir, rsm_level);
+	g_normal = oct_decode(geometry.xy);
+	g_flux = geometry.z > 0.0 ? textureLod(flux_map, dir, rsm_level).rgb * flux_scale : vec3(0);
+	// offset half a cell along the normal so flux is not injected behind the surface
+	vec3 pos = light_pos + dir * geometry.z + g_normal * (0.5 * volume_cell);
+	g_cell = ivec3(floor((pos - volume_min) / volume_cell));
+	gl_Position = vec4(0.0, 0.0, 0.0, 1.0);
+}
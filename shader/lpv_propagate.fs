@@ -0,0 +1,50 @@
+#version 330 core
+
+layout (location = 0) out vec4 o_r;
+layout (location = 1) out vec4 o_g;
+layout (location = 2) out vec4 o_b;
+layout (location = 3) out vec4 o_sum_r;
+layout (location = 4) out vec4 o_sum_g;
+layout (location = 5) out vec4 o_sum_b;
+
+flat in int f_layer;
+
+uniform sampler3D sh_r; // result of the previous iteration
+uniform sampler3D sh_g;
+uniform sampler3D sh_b;
+uniform int volume_size;
+
+const float PI = 3.14159265;
+const float FACE_SOLID_ANGLE = 4.0 * PI / 6.0; // approximate solid angle of a cell face seen from the cell center
+
+const ivec3 directions[6] = ivec3[](ivec3(1, 0, 0), ivec3(-1, 0, 0), ivec3(0, 1, 0), ivec3(0, -1, 0), ivec3(0, 0, 1), ivec3(0, 0, -1));
+
+vec4 sh_eval(vec3 d) {
+	return vec4(0.282094792, -0.488602512 * d.y, 0.488602512 * d.z, -0.488602512 * d.x);
+}
+
+vec4 sh_cosine_lobe(vec3 n) {
+	return vec4(0.886226925, -1.02332671 * n.y, 1.02332671 * n.z, -1.02332671 * n.x);
+}
+
+// gather light flowing in from the 6 neighbours: the neighbour's intensity towards this cell times the face solid angle is the flux through the face,
+// which is re-emitted as a cosine lobe along that direction (face center direction only, no occlusion)
+void main() {
+	ivec3 cell = ivec3(ivec2(gl_FragCoord.xy), f_layer);
+	vec4 r = vec4(0), g = vec4(0), b = vec4(0);
+	for (int i = 0; i < 6; i++) {
+		ivec3 neighbor = cell - directions[i];
+		if (any(lessThan(neighbor, ivec3(0))) || any(greaterThanEqual(neighbor, ivec3(volume_size)))) continue;
+		vec3 d = vec3(directions[i]);
+		vec4 eval = sh_eval(d);
+		vec3 flux = max(vec3(dot(texelFetch(sh_r, neighbor, 0), eval), dot(texelFetch(sh_g, neighbor, 0), eval),
+			dot(texelFetch(sh_b, neighbor, 0), eval)), 0.0) * FACE_SOLID_ANGLE;
+		vec4 lobe = sh_cosine_lobe(d) / PI;
+		r += lobe * flux.r;
+		g += lobe * flux.g;
+		b += lobe * flux.b;
+	}
+	o_r = o_sum_r = r;
+	o_g = o_sum_g = g;
+	o_b = o_sum_b = b;
+}
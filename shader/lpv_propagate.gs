@@ -0,0 +1,16 @@
+#version 330 core
+layout (triangles) in;
+layout (triangle_strip, max_vertices=3) out;
+
+flat in int g_layer[];
+flat out int f_layer;
+
+void main() {
+    for (int i = 0; i < 3; ++i) {
+        gl_Layer = g_layer[0];
+        f_layer = g_layer[0];
+        gl_Position = gl_in[i].gl_Position;
+        EmitVertex();
+    }
+    EndPrimitive();
+}
@@ -0,0 +1,10 @@
+#version 330 core
+
+flat out int g_layer;
+
+// one instance per grid layer, the triangle covering the layer needs no vertex data
+void main() {
+    vec2 p = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);
+    g_layer = gl_InstanceID;
+}
@@ -38,6 +38,7 @@ out vec4 o_color;
 in vec3 f_normal;
 in vec3 f_pos;
 in vec2 f_coords;
+in vec2 f_lightmap_coords;
 
 #define MAX_MULTILIGHT_NUM 4
 
@@ -49,6 +50,8 @@ uniform SpotLight spot_lights[MAX_MULTILIGHT_NUM];
 uniform int spot_light_num;
 uniform vec3 view_pos;
 uniform Material material;
+uniform int use_lightmap; // when 1, all diffuse light comes from the baked lightmap
+uniform sampler2D lightmap;
 
 vec3 calc_dir_light(DirLight light, vec3 normal, vec3 view_dir) {
 	vec3 light_dir = normalize(-light.dir);
@@ -102,6 +105,12 @@ void main() {
 	vec3 norm = normalize(f_normal);
 	vec3 view_dir = normalize(view_pos - f_pos);
 	
+	// the lightmap stores direct plus indirect diffuse irradiance, so just multiply by albedo
+	if (use_lightmap != 0) {
+		o_color = vec4(texture(lightmap, f_lightmap_coords).rgb * vec3(texture(material.diffuse, f_coords)), 1.0);
+		return;
+	}
+
 	vec3 result = vec3(0, 0, 0);
 	if (dir_light_num > 0) result += calc_dir_light(dir_light, norm, view_dir);
     for(int i = 0; i < point_light_num; i++) result += calc_point_light(point_lights[i], norm, f_pos, view_dir);
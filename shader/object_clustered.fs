@@ -0,0 +1,94 @@
+#version 330 core
+
+struct Material {
+    sampler2D diffuse;
+    sampler2D specular;
+    float shininess;
+};
+
+struct DirLight {
+	vec3 dir;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+out vec4 o_color;
+
+in vec3 f_normal;
+in vec3 f_pos;
+in vec2 f_coords;
+
+const ivec3 grid_size = ivec3(16, 9, 24); //must match the cluster grid in Clustered
+#define LIGHT_STRIDE 5
+
+uniform DirLight dir_light;
+uniform int dir_light_num;
+uniform vec3 view_pos;
+uniform Material material;
+uniform mat4 view;
+
+uniform usamplerBuffer cluster_buf; //start and length of each cluster's light list
+uniform usamplerBuffer index_buf; //light lists of all clusters
+uniform samplerBuffer light_buf; //light data
+uniform vec2 screen_size;
+uniform float z_near;
+uniform float z_scale;
+
+vec3 calc_dir_light(DirLight light, vec3 normal, vec3 view_dir, vec3 diffuse_color, vec3 specular_color) {
+	vec3 light_dir = normalize(-light.dir);
+    float diff = max(dot(normal, light_dir), 0.0);
+    vec3 reflect_dir = reflect(-light_dir, normal);
+    float spec = pow(max(dot(view_dir, reflect_dir), 0.0), material.shininess);
+    vec3 ambient  = light.ambient  * diffuse_color;
+    vec3 diffuse  = light.diffuse  * diff * diffuse_color;
+    vec3 specular = light.specular * spec * specular_color;
+    return (ambient + diffuse + specular);
+}
+
+//point and spot lights share one path: a point light's cut off covers every direction, a spot light's attenuation is 1
+vec3 calc_light(int id, vec3 normal, vec3 frag_pos, vec3 view_dir, vec3 diffuse_color, vec3 specular_color) {
+    vec4 pos_outer   = texelFetch(light_buf, id * LIGHT_STRIDE);
+    vec4 ambient_c   = texelFetch(light_buf, id * LIGHT_STRIDE + 1);
+    vec4 diffuse_l   = texelFetch(light_buf, id * LIGHT_STRIDE + 2);
+    vec4 specular_q  = texelFetch(light_buf, id * LIGHT_STRIDE + 3);
+    vec4 dir_cut     = texelFetch(light_buf, id * LIGHT_STRIDE + 4);
+
+    vec3 light_dir = normalize(pos_outer.xyz - frag_pos);
+    float theta = dot(light_dir, -dir_cut.xyz);
+    float intensity = clamp((theta - pos_outer.w) / (dir_cut.w - pos_outer.w), 0.0, 1.0);
+
+    float diff = max(dot(normal, light_dir), 0.0);
+    vec3 reflect_dir = reflect(-light_dir, normal);
+    float spec = pow(max(dot(view_dir, reflect_dir), 0.0), material.shininess);
+
+	float distance    = length(pos_outer.xyz - frag_pos);
+    float attenuation = 1.0 / (ambient_c.w + diffuse_l.w * distance + specular_q.w * (distance * distance));
+    vec3 ambient  = ambient_c.rgb  * diffuse_color;
+    vec3 diffuse  = intensity * diffuse_l.rgb  * diff * diffuse_color;
+    vec3 specular = intensity * specular_q.rgb * spec * specular_color;
+    return (ambient + diffuse + specular) * attenuation;
+}
+
+void main() {
+
+	vec3 norm = normalize(f_normal);
+	vec3 view_dir = normalize(view_pos - f_pos);
+    vec3 diffuse_color = vec3(texture(material.diffuse, f_coords));
+    vec3 specular_color = vec3(texture(material.specular, f_coords));
+	
+	vec3 result = vec3(0, 0, 0);
+	if (dir_light_num > 0) result += calc_dir_light(dir_light, norm, view_dir, diffuse_color, specular_color);
+
+    //find the cluster of this fragment
+    float depth = -(view * vec4(f_pos, 1.0)).z;
+    ivec3 cluster = ivec3(ivec2(gl_FragCoord.xy / screen_size * vec2(grid_size.xy)), int(floor(log(depth / z_near) * z_scale)));
+    cluster = clamp(cluster, ivec3(0), grid_size - 1);
+    uvec2 list = texelFetch(cluster_buf, (cluster.z * grid_size.y + cluster.y) * grid_size.x + cluster.x).xy;
+    for (uint i = 0u; i < list.y; i++) {
+        int id = int(texelFetch(index_buf, int(list.x + i)).x);
+        result += calc_light(id, norm, f_pos, view_dir, diffuse_color, specular_color);
+    }
+
+    o_color = vec4(result, 1.0);
+}
@@ -0,0 +1,150 @@
+#version 330 core
+
+struct Material {
+    sampler2D diffuse;
+    sampler2D specular;
+    float shininess;
+};
+
+struct DirLight {
+	vec3 dir;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+struct PointLight {
+    vec3 pos;
+	float constant;
+    float linear;
+    float quadratic;
+	vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+struct SpotLight {
+	vec3 pos;
+	vec3 dir;
+	float cut_off;
+	float outer_cut_off;
+	vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+out vec4 o_color;
+
+in vec3 f_normal;
+in vec3 f_pos;
+in vec2 f_coords;
+
+#define MAX_MULTILIGHT_NUM 4
+
+uniform DirLight dir_light;
+uniform int dir_light_num;
+uniform PointLight point_lights[MAX_MULTILIGHT_NUM];
+uniform int point_light_num;
+uniform SpotLight spot_lights[MAX_MULTILIGHT_NUM];
+uniform int spot_light_num;
+uniform vec3 view_pos;
+uniform Material material;
+
+uniform samplerCubeShadow depth_map; // depth compare enabled, linear filtering gives 2x2 hardware PCF
+uniform float far_plane;
+uniform float shadow_near; // near plane of the cube shadow face projection
+
+uniform sampler3D probe_r; // L1 SH irradiance coefficients of R, G and B
+uniform sampler3D probe_g;
+uniform sampler3D probe_b;
+uniform vec3 probe_min; // minimum corner of the grid, probes sit at cell centers
+uniform vec3 probe_extent; // size of the grid
+uniform float probe_intensity; // 0 while baking so only direct light is rendered
+
+const float PI = 3.14159265;
+
+float calc_shadow(vec3 normal) {
+	vec3 frag_to_light = f_pos - point_lights[0].pos;
+	// offset about one texel along the normal instead of a constant compare bias
+	frag_to_light += normal * (2.0 * length(frag_to_light) / float(textureSize(depth_map, 0).x));
+	// the view distance on the face is the major component, convert it to projected depth to compare
+	vec3 a = abs(frag_to_light);
+	float d = max(a.x, max(a.y, a.z));
+	float ref = 0.5 * (far_plane + shadow_near) / (far_plane - shadow_near) + 0.5 - far_plane * shadow_near / ((far_plane - shadow_near) * d);
+	return 1.0 - texture(depth_map, vec4(frag_to_light, ref));
+}
+
+vec4 sh_eval(vec3 d) {
+	return vec4(0.282094792, -0.488602512 * d.y, 0.488602512 * d.z, -0.488602512 * d.x);
+}
+
+//one trilinear lookup in the probe grid; coefficients are already irradiance, evaluate along the normal and multiply by albedo
+vec3 probe_indirect(vec3 normal) {
+	vec3 uvw = (f_pos - probe_min) / probe_extent;
+	vec4 basis = sh_eval(normal);
+	vec3 irradiance = vec3(dot(texture(probe_r, uvw), basis), dot(texture(probe_g, uvw), basis), dot(texture(probe_b, uvw), basis));
+	return max(irradiance, 0.0) / PI * vec3(texture(material.diffuse, f_coords)) * probe_intensity;
+}
+
+vec3 calc_dir_light(DirLight light, vec3 normal, vec3 view_dir, float shadow_factor) {
+	vec3 light_dir = normalize(-light.dir);
+    float diff = max(dot(normal, light_dir), 0.0);
+    vec3 reflect_dir = reflect(-light_dir, normal);
+    float spec = pow(max(dot(view_dir, reflect_dir), 0.0), material.shininess);
+    vec3 ambient  = light.ambient  * vec3(texture(material.diffuse, f_coords));
+    vec3 diffuse  = light.diffuse  * diff * vec3(texture(material.diffuse, f_coords));
+    vec3 specular = light.specular * spec * vec3(texture(material.specular, f_coords));
+	return ambient + (diffuse + specular) * (1.0 - shadow_factor);
+}
+
+vec3 calc_point_light(PointLight light, vec3 normal, vec3 view_dir, float shadow_factor) {
+	//return indirect_light();
+	vec3 light_dir = normalize(light.pos - f_pos);
+    float diff = max(dot(normal, light_dir), 0.0);
+    vec3 reflect_dir = reflect(-light_dir, normal);
+    float spec = pow(max(dot(view_dir, reflect_dir), 0.0), material.shininess);
+    
+	float distance    = length(light.pos - f_pos);
+    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));    
+    vec3 ambient  = light.ambient  * vec3(texture(material.diffuse, f_coords));
+    vec3 diffuse  = light.diffuse  * diff * vec3(texture(material.diffuse, f_coords));
+    vec3 specular = light.specular * spec * vec3(texture(material.specular, f_coords));
+    ambient  *= attenuation;
+    diffuse  *= attenuation;
+    specular *= attenuation;
+	return ambient + (diffuse + specular) * (1.0 - shadow_factor);
+}
+
+vec3 calc_spot_light(SpotLight light, vec3 normal, vec3 view_dir, float shadow_factor) {
+	vec3 light_dir = normalize(light.pos - f_pos);
+
+	float theta = dot(light_dir, normalize(-light.dir));
+	float epsilon   = light.cut_off - light.outer_cut_off;
+	float intensity = clamp((theta - light.outer_cut_off) / epsilon, 0.0, 1.0);
+	
+	float diff = max(dot(normal, light_dir), 0.0);
+	vec3 reflect_dir = reflect(-light_dir, normal);
+	float spec = pow(max(dot(view_dir, reflect_dir), 0.0), material.shininess);
+
+	vec3 ambient  = light.ambient  * vec3(texture(material.diffuse, f_coords));
+	vec3 diffuse  = intensity * light.diffuse  * diff * vec3(texture(material.diffuse, f_coords));
+	vec3 specular = intensity * light.specular * spec * vec3(texture(material.specular, f_coords));
+
+	return ambient + (diffuse + specular) * (1.0 - shadow_factor);
+}
+
+void main() {
+
+	vec3 norm = normalize(f_normal);
+	vec3 view_dir = normalize(view_pos - f_pos);
+	
+	float shadow_factor = calc_shadow(norm);
+
+	vec3 result = vec3(0, 0, 0);
+	if (dir_light_num > 0) result += calc_dir_light(dir_light, norm, view_dir, shadow_factor);
+    for(int i = 0; i < point_light_num; i++) result += calc_point_light(point_lights[i], norm, view_dir, shadow_factor);
+    for(int i = 0; i < spot_light_num; i++) result += calc_spot_light(spot_lights[i], norm, view_dir, shadow_factor);    
+	result += probe_indirect(norm);
+
+    o_color = vec4(result, 1.0);
+}
@@ -50,51 +50,70 @@ uniform int spot_light_num;
 uniform vec3 view_pos;
 uniform Material material;
 
-uniform samplerCube depth_map;
-uniform samplerCube indirect_map;
-uniform samplerCube pos_map;
-uniform samplerCube normal_map;
+uniform samplerCubeShadow depth_map; // depth compare enabled, linear filtering gives 2x2 hardware PCF
 uniform float far_plane;
-
-#define SAMPLE_NUM 15
-
-
-float rand(int x, int y){
-	return fract(sin(x * 12.9898 + y * 78.233) * 43758.5453);
+uniform float shadow_near; // near plane of the cube shadow face projection
+uniform mat4 view;
+
+// 2D RSM for spot and directional lights
+uniform bool rsm_flat;
+uniform sampler2DShadow flat_depth_map; // depth compare enabled, returns 1 outside the RSM
+uniform mat4 rsm_matrix; // light projection * view matrix
+uniform mat4 rsm_view;
+uniform vec2 rsm_scale; // tangent of the half angle for perspective, half width and height for orthographic
+uniform bool rsm_ortho;
+
+uniform sampler2D indirect_low; //low resolution indirect light
+uniform sampler2D normal_depth_low; //low resolution normal and linear depth
+uniform vec2 indirect_scale; //ratio of low resolution to screen resolution
+
+float calc_flat_shadow(vec3 normal) {
+	// offset about one texel along the normal, texel size in world space follows from linear depth
+	float depth = -(rsm_view * vec4(f_pos, 1.0)).z;
+	float texel = 2.0 * rsm_scale.x * (rsm_ortho ? 1.0 : depth) / float(textureSize(flat_depth_map, 0).x);
+	vec4 clip = rsm_matrix * vec4(f_pos + normal * texel, 1.0);
+	if (clip.w <= 0.0) return 0.0;
+	vec3 p = clip.xyz / clip.w * 0.5 + 0.5;
+	if (p.z > 1.0) return 0.0;
+	return 1.0 - texture(flat_depth_map, p);
 }
 
 float calc_shadow(vec3 normal) {
+	if (rsm_flat) return calc_flat_shadow(normal);
 	vec3 frag_to_light = f_pos - point_lights[0].pos;
-	float closest_depth = texture(depth_map, frag_to_light).r * far_plane;
-	float current_depth = length(frag_to_light);
-	float bias = max(0.05 * (1.0 - dot(normal, -normalize(frag_to_light))), 0.005);
-    float shadow = (current_depth - bias > closest_depth) ? 1.0 : 0.0;
-    return shadow;
+	// offset about one texel along the normal instead of a constant compare bias
+	frag_to_light += normal * (2.0 * length(frag_to_light) / float(textureSize(depth_map, 0).x));
+	// the view distance on the face is the major component, convert it to projected depth to compare
+	vec3 a = abs(frag_to_light);
+	float d = max(a.x, max(a.y, a.z));
+	float ref = 0.5 * (far_plane + shadow_near) / (far_plane - shadow_near) + 0.5 - far_plane * shadow_near / ((far_plane - shadow_near) * d);
+	return 1.0 - texture(depth_map, vec4(frag_to_light, ref));
 }
 
-vec3 indirect_light() {
-	vec3 frag_to_light = normalize(f_pos - point_lights[0].pos);
+//weight the 4 nearest low resolution texels by bilinear, depth and normal similarity so indirect light does not bleed across edges
+vec3 upsample_indirect(vec3 normal) {
+	float depth = -(view * vec4(f_pos, 1.0)).z;
+	vec2 p = gl_FragCoord.xy * indirect_scale - 0.5;
+	ivec2 base = ivec2(floor(p));
+	vec2 f = p - vec2(base);
+	ivec2 size = textureSize(indirect_low, 0);
 	vec3 ret = vec3(0);
-	float step = 1.0 / SAMPLE_NUM;
+	vec3 fallback = vec3(0);
 	float weight_sum = 0.0;
-	for (int i = 0; i <= SAMPLE_NUM; i++) {
-		for (int j = 0; j <= SAMPLE_NUM; j++) {
-			vec3 frag_to_light_noised = frag_to_light + normalize(vec3(2*rand(i,j)-1, 2*rand(i*2,j)-1, 2*rand(i,j*2)-1));
-			vec3 psai = texture(indirect_map, frag_to_light_noised).rgb;
-			vec3 pos = (texture(pos_map, frag_to_light_noised).rgb - 0.5) * 2.0;
-			vec3 normal = (texture(normal_map, frag_to_light_noised).rgb - 0.5) * 2.0;
-			vec3 distance = pos - f_pos;
-			float distance_square = dot(distance, distance);
-			float weight = 1.0 / (2.5 + dot(frag_to_light, normalize(frag_to_light_noised)));
-			weight_sum += weight;
-			ret += psai * weight * max(0, dot(normalize(f_normal), distance)) * max(0, dot(normal, -distance)) / (distance_square * distance_square);
-		}
+	for (int i = 0; i < 4; i++) {
+		ivec2 offset = ivec2(i & 1, i >> 1);
+		ivec2 texel = clamp(base + offset, ivec2(0), size - 1);
+		vec3 indirect = texelFetch(indirect_low, texel, 0).rgb;
+		vec4 normal_depth = texelFetch(normal_depth_low, texel, 0);
+		float bilinear = (offset.x == 1 ? f.x : 1.0 - f.x) * (offset.y == 1 ? f.y : 1.0 - f.y);
+		float depth_weight = 1.0 / (1e-4 + abs(depth - normal_depth.w) / depth);
+		float normal_weight = pow(max(dot(normal, normal_depth.xyz), 0.0), 8.0);
+		float weight = normal_depth.w > 0.0 ? bilinear * depth_weight * normal_weight : 0.0;
+		ret += indirect * weight;
+		weight_sum += weight;
+		fallback += indirect * bilinear;
 	}
-	ret /= weight_sum;
-	if (ret.x > 1.0) ret.x = 1.0;
-	if (ret.y > 1.0) ret.y = 1.0;
-	if (ret.z > 1.0) ret.z = 1.0;
-	return 0.6 * ret;
+	return weight_sum > 1e-4 ? ret / weight_sum : fallback;
 }
 
 vec3 calc_dir_light(DirLight light, vec3 normal, vec3 view_dir, float shadow_factor) {
@@ -105,7 +124,7 @@ vec3 calc_dir_light(DirLight light, vec3 normal, vec3 view_dir, float shadow_fac
     vec3 ambient  = light.ambient  * vec3(texture(material.diffuse, f_coords));
     vec3 diffuse  = light.diffuse  * diff * vec3(texture(material.diffuse, f_coords));
     vec3 specular = light.specular * spec * vec3(texture(material.specular, f_coords));
-	return ambient + (diffuse + specular) * (1.0 - shadow_factor) + indirect_light();
+	return ambient + (diffuse + specular) * (1.0 - shadow_factor);
 }
 
 vec3 calc_point_light(PointLight light, vec3 normal, vec3 view_dir, float shadow_factor) {
@@ -123,7 +142,7 @@ vec3 calc_point_light(PointLight light, vec3 normal, vec3 view_dir, float shadow
     ambient  *= attenuation;
     diffuse  *= attenuation;
     specular *= attenuation;
-	return ambient + (diffuse + specular) * (1.0 - shadow_factor) + indirect_light();
+	return ambient + (diffuse + specular) * (1.0 - shadow_factor);
 }
 
 vec3 calc_spot_light(SpotLight light, vec3 normal, vec3 view_dir, float shadow_factor) {
@@ -141,7 +160,7 @@ vec3 calc_spot_light(SpotLight light, vec3 normal, vec3 view_dir, float shadow_f
 	vec3 diffuse  = intensity * light.diffuse  * diff * vec3(texture(material.diffuse, f_coords));
 	vec3 specular = intensity * light.specular * spec * vec3(texture(material.specular, f_coords));
 
-	return ambient + (diffuse + specular) * (1.0 - shadow_factor) + indirect_light();
+	return ambient + (diffuse + specular) * (1.0 - shadow_factor);
 }
 
 void main() {
@@ -155,6 +174,7 @@ void main() {
 	if (dir_light_num > 0) result += calc_dir_light(dir_light, norm, view_dir, shadow_factor);
     for(int i = 0; i < point_light_num; i++) result += calc_point_light(point_lights[i], norm, view_dir, shadow_factor);
     for(int i = 0; i < spot_light_num; i++) result += calc_spot_light(spot_lights[i], norm, view_dir, shadow_factor);    
+	result += upsample_indirect(norm);
 
     o_color = vec4(result, 1.0);
 }
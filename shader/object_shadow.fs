@@ -50,16 +50,69 @@ uniform int spot_light_num;
 uniform vec3 view_pos;
 uniform Material material;
 
-uniform samplerCube depth_map;
+#define MAX_SHADOW_NUM 4
+
+// the first shadow_num point lights cast shadows, their 6 cube faces are laid out 3x2 in the atlas
+uniform sampler2DShadow shadow_atlas; // depth compare enabled, linear filtering gives 2x2 hardware PCF
+// xy: tile origin in pixels, z: face resolution, w: 1 for dual paraboloid (both halves on the first row)
+uniform vec4 shadow_tiles[MAX_SHADOW_NUM];
+uniform vec2 atlas_size;
+uniform int shadow_num;
 uniform float far_plane;
+uniform float shadow_near; // near plane of the cube shadow face projection
+
+// must match the lookAt of each face when rendering
+const vec3 face_dirs[6] = vec3[](vec3(1, 0, 0), vec3(-1, 0, 0), vec3(0, 1, 0), vec3(0, -1, 0), vec3(0, 0, 1), vec3(0, 0, -1));
+const vec3 face_ups[6] = vec3[](vec3(0, -1, 0), vec3(0, -1, 0), vec3(0, 0, 1), vec3(0, 0, -1), vec3(0, -1, 0), vec3(0, -1, 0));
+
+#define MAX_CASCADE_NUM 4
+
+// cascaded shadows of the directional light, none when cascade_num is 0
+uniform sampler2DArrayShadow cascade_map;
+uniform mat4 cascade_matrices[MAX_CASCADE_NUM];
+uniform float cascade_splits[MAX_CASCADE_NUM]; // far depth of each cascade
+uniform int cascade_num;
+uniform mat4 view;
+
+float calc_dir_shadow(vec3 normal) {
+	float depth = -(view * vec4(f_pos, 1.0)).z;
+	int id = 0;
+	while (id < cascade_num && depth > cascade_splits[id]) ++id;
+	if (id >= cascade_num) return 0.0;
+	vec3 proj = (cascade_matrices[id] * vec4(f_pos, 1.0)).xyz * 0.5 + 0.5;
+	float bias = max(0.002 * (1.0 - dot(normal, -normalize(dir_light.dir))), 0.0005);
+	return 1.0 - texture(cascade_map, vec4(proj.xy, id, proj.z - bias));
+}
+
+// projected depth of view distance d
+float face_depth(float d) {
+	return 0.5 * (far_plane + shadow_near) / (far_plane - shadow_near) + 0.5 - far_plane * shadow_near / ((far_plane - shadow_near) * d);
+}
 
-float calc_shadow(vec3 normal) {
-	vec3 frag_to_light = f_pos - point_lights[0].pos;
-	float closest_depth = texture(depth_map, frag_to_light).r * far_plane;
+float calc_shadow(vec3 normal, int id) {
+	vec4 tile = shadow_tiles[id];
+	if (id >= shadow_num || tile.z <= 0.0) return 0.0;
+	vec3 frag_to_light = f_pos - point_lights[id].pos;
+	// offset about one texel along the normal instead of a constant compare bias
+	frag_to_light += normal * (2.0 * length(frag_to_light) / tile.z);
 	float current_depth = length(frag_to_light);
-	float bias = max(0.05 * (1.0 - dot(normal, -normalize(frag_to_light))), 0.005);
-    float shadow = (current_depth - bias > closest_depth) ? 1.0 : 0.0;
-    return shadow;
+	bool paraboloid = tile.w > 0.5;
+	vec3 a = abs(frag_to_light);
+	int face;
+	if (paraboloid) face = frag_to_light.z >= 0.0 ? 4 : 5; // the two halves face the same way as the +-z cube faces
+	else face = a.x >= a.y && a.x >= a.z ? (frag_to_light.x > 0.0 ? 0 : 1)
+		: (a.y >= a.z ? (frag_to_light.y > 0.0 ? 2 : 3) : (frag_to_light.z > 0.0 ? 4 : 5));
+	vec3 dir = face_dirs[face];
+	vec3 right = normalize(cross(dir, face_ups[face]));
+	vec3 up = cross(right, dir);
+	vec2 plane = vec2(dot(frag_to_light, right), dot(frag_to_light, up));
+	vec2 uv = (paraboloid ? plane / (current_depth + dot(frag_to_light, dir)) : plane / dot(frag_to_light, dir)) * 0.5 + 0.5;
+	uv = clamp(uv, 1.0 / tile.z, 1.0 - 1.0 / tile.z); // keep bilinear taps inside this face
+	vec2 cell = paraboloid ? vec2(face - 4, 0) : vec2(face % 3, face / 3);
+	uv = (tile.xy + (cell + uv) * tile.z) / atlas_size;
+	// paraboloid depth is linear distance, cube faces store projected depth
+	float ref = paraboloid ? current_depth / far_plane : face_depth(dot(frag_to_light, dir));
+	return 1.0 - texture(shadow_atlas, vec3(uv, ref));
 }
 
 vec3 calc_dir_light(DirLight light, vec3 normal, vec3 view_dir, float shadow_factor) {
@@ -116,9 +169,9 @@ void main() {
 	vec3 view_dir = normalize(view_pos - f_pos);
 	
 	vec3 result = vec3(0, 0, 0);
-	float shadow_factor = calc_shadow(norm);
-	if (dir_light_num > 0) result += calc_dir_light(dir_light, norm, view_dir, shadow_factor);
-    for(int i = 0; i < point_light_num; i++) result += calc_point_light(point_lights[i], norm, view_dir, shadow_factor);
+	float shadow_factor = calc_shadow(norm, 0);
+	if (dir_light_num > 0) result += calc_dir_light(dir_light, norm, view_dir, cascade_num > 0 ? calc_dir_shadow(norm) : shadow_factor);
+    for(int i = 0; i < point_light_num; i++) result += calc_point_light(point_lights[i], norm, view_dir, calc_shadow(norm, i));
     for(int i = 0; i < spot_light_num; i++) result += calc_spot_light(spot_lights[i], norm, view_dir, shadow_factor);    
 
     o_color = vec4(result, 1.0);
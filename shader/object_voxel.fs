@@ -0,0 +1,174 @@
+#version 330 core
+
+struct Material {
+    sampler2D diffuse;
+    sampler2D specular;
+    float shininess;
+};
+
+struct DirLight {
+	vec3 dir;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+struct PointLight {
+    vec3 pos;
+	float constant;
+    float linear;
+    float quadratic;
+	vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+struct SpotLight {
+	vec3 pos;
+	vec3 dir;
+	float cut_off;
+	float outer_cut_off;
+	vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+out vec4 o_color;
+
+in vec3 f_normal;
+in vec3 f_pos;
+in vec2 f_coords;
+
+#define MAX_MULTILIGHT_NUM 4
+
+uniform DirLight dir_light;
+uniform int dir_light_num;
+uniform PointLight point_lights[MAX_MULTILIGHT_NUM];
+uniform int point_light_num;
+uniform SpotLight spot_lights[MAX_MULTILIGHT_NUM];
+uniform int spot_light_num;
+uniform vec3 view_pos;
+uniform Material material;
+
+uniform samplerCubeShadow depth_map; // depth compare enabled, linear filtering gives 2x2 hardware PCF
+uniform float far_plane;
+uniform float shadow_near; // near plane of the cube shadow face projection
+
+uniform sampler3D voxel_radiance; // voxel outgoing radiance (premultiplied) and occupancy, mipmapped
+uniform vec3 voxel_min; // minimum corner of the grid
+uniform float voxel_extent; // edge length of the grid
+uniform float voxel_cell; // cell edge length
+uniform float voxel_intensity;
+
+const float PI = 3.14159265;
+
+float calc_shadow(vec3 normal) {
+	vec3 frag_to_light = f_pos - point_lights[0].pos;
+	// offset about one texel along the normal instead of a constant compare bias
+	frag_to_light += normal * (2.0 * length(frag_to_light) / float(textureSize(depth_map, 0).x));
+	// the view distance on the face is the major component, convert it to projected depth to compare
+	vec3 a = abs(frag_to_light);
+	float d = max(a.x, max(a.y, a.z));
+	float ref = 0.5 * (far_plane + shadow_near) / (far_plane - shadow_near) + 0.5 - far_plane * shadow_near / ((far_plane - shadow_near) * d);
+	return 1.0 - texture(depth_map, vec4(frag_to_light, ref));
+}
+
+// march the cone near to far, pick the mip level from the cone diameter, blend front to back
+// step is half the diameter, so cost depends on grid resolution only
+vec3 trace_cone(vec3 origin, vec3 dir, float tan_half) {
+	vec3 color = vec3(0.0);
+	float alpha = 0.0;
+	float dist = voxel_cell;
+	for (int i = 0; i < 64 && alpha < 0.95; ++i) {
+		float diameter = max(voxel_cell, 2.0 * tan_half * dist);
+		vec3 uvw = (origin + dir * dist - voxel_min) / voxel_extent;
+		if (any(lessThan(uvw, vec3(0.0))) || any(greaterThan(uvw, vec3(1.0)))) break;
+		vec4 s = textureLod(voxel_radiance, uvw, log2(diameter / voxel_cell));
+		color += (1.0 - alpha) * s.rgb;
+		alpha += (1.0 - alpha) * s.a;
+		dist += diameter * 0.5;
+	}
+	return color;
+}
+
+// diffuse: one 60 degree cone along the normal and 5 tilted by 60 degrees, weights sum to pi, approximating the cosine weighted hemisphere
+// specular: one cone along the reflection, aperture from shininess
+// start one cell along the normal to skip the surface's own voxel
+vec3 voxel_indirect(vec3 normal, vec3 view_dir) {
+	vec3 origin = f_pos + normal * voxel_cell;
+	vec3 t = normalize(cross(abs(normal.y) < 0.99 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0), normal));
+	vec3 b = cross(normal, t);
+	vec3 diffuse = PI / 4.0 * trace_cone(origin, normal, 0.577);
+	for (int i = 0; i < 5; ++i) {
+		float phi = 2.0 * PI * float(i) / 5.0;
+		vec3 dir = normal * 0.5 + (t * cos(phi) + b * sin(phi)) * 0.866025;
+		diffuse += 3.0 * PI / 20.0 * trace_cone(origin, dir, 0.577);
+	}
+	diffuse *= vec3(texture(material.diffuse, f_coords)) / PI;
+	float tan_half = clamp(sqrt(2.0 / (material.shininess + 2.0)), 0.05, 0.577);
+	vec3 specular = trace_cone(origin, reflect(-view_dir, normal), tan_half) * vec3(texture(material.specular, f_coords));
+	return (diffuse + specular) * voxel_intensity;
+}
+
+vec3 calc_dir_light(DirLight light, vec3 normal, vec3 view_dir, float shadow_factor) {
+	vec3 light_dir = normalize(-light.dir);
+    float diff = max(dot(normal, light_dir), 0.0);
+    vec3 reflect_dir = reflect(-light_dir, normal);
+    float spec = pow(max(dot(view_dir, reflect_dir), 0.0), material.shininess);
+    vec3 ambient  = light.ambient  * vec3(texture(material.diffuse, f_coords));
+    vec3 diffuse  = light.diffuse  * diff * vec3(texture(material.diffuse, f_coords));
+    vec3 specular = light.specular * spec * vec3(texture(material.specular, f_coords));
+	return ambient + (diffuse + specular) * (1.0 - shadow_factor);
+}
+
+vec3 calc_point_light(PointLight light, vec3 normal, vec3 view_dir, float shadow_factor) {
+	//return indirect_light();
+	vec3 light_dir = normalize(light.pos - f_pos);
+    float diff = max(dot(normal, light_dir), 0.0);
+    vec3 reflect_dir = reflect(-light_dir, normal);
+    float spec = pow(max(dot(view_dir, reflect_dir), 0.0), material.shininess);
+    
+	float distance    = length(light.pos - f_pos);
+    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));    
+    vec3 ambient  = light.ambient  * vec3(texture(material.diffuse, f_coords));
+    vec3 diffuse  = light.diffuse  * diff * vec3(texture(material.diffuse, f_coords));
+    vec3 specular = light.specular * spec * vec3(texture(material.specular, f_coords));
+    ambient  *= attenuation;
+    diffuse  *= attenuation;
+    specular *= attenuation;
+	return ambient + (diffuse + specular) * (1.0 - shadow_factor);
+}
+
+vec3 calc_spot_light(SpotLight light, vec3 normal, vec3 view_dir, float shadow_factor) {
+	vec3 light_dir = normalize(light.pos - f_pos);
+
+	float theta = dot(light_dir, normalize(-light.dir));
+	float epsilon   = light.cut_off - light.outer_cut_off;
+	float intensity = clamp((theta - light.outer_cut_off) / epsilon, 0.0, 1.0);
+	
+	float diff = max(dot(normal, light_dir), 0.0);
+	vec3 reflect_dir = reflect(-light_dir, normal);
+	float spec = pow(max(dot(view_dir, reflect_dir), 0.0), material.shininess);
+
+	vec3 ambient  = light.ambient  * vec3(texture(material.diffuse, f_coords));
+	vec3 diffuse  = intensity * light.diffuse  * diff * vec3(texture(material.diffuse, f_coords));
+	vec3 specular = intensity * light.specular * spec * vec3(texture(material.specular, f_coords));
+
+	return ambient + (diffuse + specular) * (1.0 - shadow_factor);
+}
+
+void main() {
+
+	vec3 norm = normalize(f_normal);
+	vec3 view_dir = normalize(view_pos - f_pos);
+	
+	float shadow_factor = calc_shadow(norm);
+
+	vec3 result = vec3(0, 0, 0);
+	if (dir_light_num > 0) result += calc_dir_light(dir_light, norm, view_dir, shadow_factor);
+    for(int i = 0; i < point_light_num; i++) result += calc_point_light(point_lights[i], norm, view_dir, shadow_factor);
+    for(int i = 0; i < spot_light_num; i++) result += calc_spot_light(spot_lights[i], norm, view_dir, shadow_factor);    
+	result += voxel_indirect(norm, view_dir);
+
+    o_color = vec4(result, 1.0);
+}
@@ -0,0 +1,13 @@
+#version 330 core
+layout (location = 0) in vec3 v_pos;
+
+uniform mat4 model;
+uniform mat4 paraboloid_view; // view matrix at the light looking at the center of the half
+uniform float far_plane;
+
+void main() {
+    vec3 p = (paraboloid_view * model * vec4(v_pos, 1.0)).xyz;
+    float len = length(p);
+    gl_ClipDistance[0] = -p.z; // keep only the half in front
+    gl_Position = vec4(p.xy / (len - p.z), len / far_plane * 2.0 - 1.0, 1.0); // depth is linear distance
+}
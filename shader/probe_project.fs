@@ -0,0 +1,50 @@
+#version 330 core
+
+// L1 SH irradiance coefficients of R, G and B
+layout (location = 0) out vec4 o_r;
+layout (location = 1) out vec4 o_g;
+layout (location = 2) out vec4 o_b;
+
+uniform samplerCube radiance_map; // direct light only cube map captured at the probe
+uniform int face_size;
+
+const float PI = 3.14159265;
+
+// unnormalized direction through (s, t) on the given cube map face
+vec3 cube_dir(int face, vec2 st) {
+	vec2 c = st * 2.0 - 1.0;
+	if (face == 0) return vec3(1.0, -c.y, -c.x);
+	if (face == 1) return vec3(-1.0, -c.y, c.x);
+	if (face == 2) return vec3(c.x, 1.0, c.y);
+	if (face == 3) return vec3(c.x, -1.0, -c.y);
+	if (face == 4) return vec3(c.x, -c.y, 1.0);
+	return vec3(-c.x, -c.y, -1.0);
+}
+
+vec4 sh_eval(vec3 d) {
+	return vec4(0.282094792, -0.488602512 * d.y, 0.488602512 * d.z, -0.488602512 * d.x);
+}
+
+// project radiance onto SH weighted by texel solid angle, then convolve with the cosine kernel (band 0 * PI, band 1 * 2PI/3)
+void main() {
+	vec4 r = vec4(0), g = vec4(0), b = vec4(0);
+	float weight_sum = 0.0;
+	for (int face = 0; face < 6; face++)
+		for (int y = 0; y < face_size; y++)
+			for (int x = 0; x < face_size; x++) {
+				vec3 d = cube_dir(face, (vec2(x, y) + 0.5) / float(face_size));
+				float len_square = dot(d, d);
+				float weight = 1.0 / (len_square * sqrt(len_square)); // proportional to the texel solid angle
+				d *= inversesqrt(len_square);
+				vec3 radiance = textureLod(radiance_map, d, 0.0).rgb;
+				vec4 basis = sh_eval(d) * weight;
+				r += basis * radiance.r;
+				g += basis * radiance.g;
+				b += basis * radiance.b;
+				weight_sum += weight;
+			}
+	vec4 band = vec4(PI, 2.0 * PI / 3.0, 2.0 * PI / 3.0, 2.0 * PI / 3.0) * (4.0 * PI / weight_sum);
+	o_r = r * band;
+	o_g = g * band;
+	o_b = b * band;
+}
@@ -4,8 +4,13 @@ in vec3 f_normal;
 in vec4 f_pos;
 in vec2 f_coords;
 
-struct PointLight {
+// light that renders the RSM, type 0: point, 1: spot, 2: directional
+struct RsmLight {
+	int type;
 	vec3 pos;
+	vec3 dir;
+	float cut_off;
+	float outer_cut_off;
 	float constant;
     float linear;
     float quadratic;
@@ -17,24 +22,32 @@ struct Material {
     sampler2D specular;
 };
 
-layout (location = 0) out vec3 o_pos;
-layout (location = 1) out vec3 o_normal;
-layout (location = 2) out vec3 o_color;
+layout (location = 0) out vec4 o_geometry; // xy: octahedron encoded normal, z: distance to the light (linear light view depth for the 2D RSM)
+layout (location = 1) out vec3 o_flux;
 
-uniform PointLight light;
+uniform RsmLight light;
+uniform mat4 rsm_view; // light view matrix of the 2D RSM
 uniform Material material;
-uniform float far_plane;
+
+// map a unit vector onto the octahedron and unfold it to [-1, 1]^2
+vec2 oct_encode(vec3 n) {
+	n /= abs(n.x) + abs(n.y) + abs(n.z);
+	vec2 p = n.xy;
+	if (n.z < 0.0) p = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	return p;
+}
 
 void main() {
-	vec3 light_dir = normalize(light.pos - vec3(f_pos));
+	vec3 light_dir = light.type == 2 ? normalize(-light.dir) : normalize(light.pos - vec3(f_pos));
 	vec3 norm = normalize(f_normal);
     float diff = max(dot(norm, light_dir), 0.0);
-    vec3 reflect_dir = reflect(-light_dir, norm);
 	float distance = length(light.pos - vec3(f_pos));
-    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+    float attenuation = light.type == 0 ? 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance)) : 1.0;
+	if (light.type == 1) {
+		float theta = dot(light_dir, normalize(-light.dir));
+		attenuation *= clamp((theta - light.outer_cut_off) / (light.cut_off - light.outer_cut_off), 0.0, 1.0);
+	}
     vec3 diffuse = light.diffuse  * diff * vec3(texture(material.diffuse, f_coords)) * attenuation;
-    o_color = diffuse;
-	o_pos = vec3(f_pos) * 0.5 + 0.5;
-	o_normal = normalize(f_normal) * 0.5 + 0.5;
-	gl_FragDepth = length(f_pos.xyz - light.pos) / far_plane;
+    o_flux = diffuse;
+	o_geometry = vec4(oct_encode(norm), light.type == 0 ? distance : -(rsm_view * f_pos).z, 0.0);
 }
@@ -3,25 +3,16 @@ layout (location = 0) in vec3 v_pos;
 layout (location = 1) in vec3 v_normal;
 layout (location = 2) in vec2 v_coords;
 
-struct PointLight {
-	vec3 pos;
-	float constant;
-    float linear;
-    float quadratic;
-    vec3 diffuse;
-};
-
-uniform PointLight light;
-
-out VsOut {
-	vec3 normal;
-	vec2 coords;
-} vs_out;
+out vec3 f_normal;
+out vec4 f_pos;
+out vec2 f_coords;
 
 uniform mat4 model;
+uniform mat4 face_matrix; // projection * view matrix of the cube face being rendered
 
 void main() {
-	vs_out.normal = transpose(inverse(mat3(model))) * v_normal;
-	vs_out.coords = v_coords;
-    gl_Position = model * vec4(v_pos, 1.0);
+	f_normal = transpose(inverse(mat3(model))) * v_normal;
+	f_coords = v_coords;
+    f_pos = model * vec4(v_pos, 1.0);
+    gl_Position = face_matrix * f_pos;
 }
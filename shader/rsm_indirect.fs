@@ -0,0 +1,139 @@
+#version 330 core
+
+layout (location = 0) out vec4 o_indirect;
+layout (location = 1) out vec4 o_normal_depth;
+
+in vec3 f_normal;
+in vec3 f_pos;
+in vec2 f_coords;
+
+uniform samplerCube geometry_map; //xy: octahedron encoded normal, z: distance to the light
+uniform samplerCube flux_map;
+uniform vec3 light_pos;
+uniform mat4 view;
+uniform int sample_num; //sample count, at most MAX_SAMPLE_NUM
+uniform int sample_offset; //first sample used this frame
+uniform vec2 frame_rotation; //per frame rotation (cos, sin)
+uniform float sample_radius; //sample disk radius relative to the unit direction
+uniform sampler2D noise_map; //per pixel rotation (cos, sin)
+
+//2D RSM for spot and directional lights
+uniform bool rsm_flat; //whether the 2D RSM is used
+uniform sampler2D flat_geometry_map; //xy: octahedron encoded normal, z: linear light view depth
+uniform sampler2D flat_flux_map;
+uniform mat4 rsm_matrix; //light projection * view matrix
+uniform mat4 rsm_inv_view; //inverse light view matrix
+uniform vec2 rsm_scale; //tangent of the half angle for perspective, half width and height for orthographic
+uniform bool rsm_ortho;
+uniform float flat_sample_radius; //sample disk radius on the 2D RSM in texture coordinates
+
+#define MAX_SAMPLE_NUM 128
+#define MAX_VPL_NUM 64
+
+uniform int vpl_num; //clustered VPL count, 0 means disk sampling
+
+//precomputed samples, xy: disk offset, z: weight
+layout (std140) uniform RsmSamples {
+	vec4 samples[MAX_SAMPLE_NUM];
+};
+
+//virtual point lights extracted from the RSM and clustered
+layout (std140) uniform Vpls {
+	vec4 vpl_pos[MAX_VPL_NUM];
+	vec4 vpl_normal[MAX_VPL_NUM];
+	vec4 vpl_flux[MAX_VPL_NUM];
+};
+
+vec3 oct_decode(vec2 p) {
+	vec3 n = vec3(p, 1.0 - abs(p.x) - abs(p.y));
+	if (n.z < 0.0) n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	return normalize(n);
+}
+
+const float PI = 3.14159265;
+
+vec3 indirect_light(vec3 f_normal) {
+	float rsm_size = float(textureSize(flux_map, 0).x);
+	vec3 frag_to_light = normalize(f_pos - light_pos);
+	//span the sample disk on the plane perpendicular to the light direction
+	vec3 up = abs(frag_to_light.y) < 0.99 ? vec3(0, 1, 0) : vec3(1, 0, 0);
+	vec3 tangent = normalize(cross(up, frag_to_light));
+	vec3 bitangent = cross(frag_to_light, tangent);
+	vec2 noise = texture(noise_map, gl_FragCoord.xy / vec2(textureSize(noise_map, 0))).xy * 2.0 - 1.0;
+	vec2 rotation = vec2(noise.x * frame_rotation.x - noise.y * frame_rotation.y, noise.x * frame_rotation.y + noise.y * frame_rotation.x);
+	vec3 ret = vec3(0);
+	float weight_sum = 0.0;
+	for (int i = 0; i < sample_num; i++) {
+		vec4 tap = samples[(sample_offset + i) % MAX_SAMPLE_NUM];
+		vec2 s = tap.xy;
+		s = vec2(s.x * rotation.x - s.y * rotation.y, s.x * rotation.y + s.y * rotation.x) * sample_radius;
+		vec3 frag_to_light_noised = frag_to_light + s.x * tangent + s.y * bitangent;
+		//sample density falls off with distance from the center, pick the mip level from the area each sample covers;
+		//a cube texel is 2/rsm_size wide at unit distance, bias one level finer to keep detail
+		float footprint = 2.0 * PI * length(s) * sample_radius / float(sample_num);
+		float lod = max(0.5 * log2(footprint) + log2(rsm_size * 0.5) - 1.0, 0.0);
+		vec3 psai = textureLod(flux_map, frag_to_light_noised, lod).rgb;
+		vec3 geometry = textureLod(geometry_map, frag_to_light_noised, lod).xyz;
+		vec3 pos = light_pos + normalize(frag_to_light_noised) * geometry.z; //rebuild the position from direction and distance
+		vec3 normal = oct_decode(geometry.xy);
+		vec3 distance = pos - f_pos;
+		float distance_square = dot(distance, distance);
+		float weight = tap.z;
+		weight_sum += weight;
+		ret += psai * weight * max(0, dot(f_normal, distance)) * max(0, dot(normal, -distance)) / (distance_square * distance_square);
+	}
+	ret /= weight_sum;
+	return 0.6 * min(ret, vec3(1.0));
+}
+
+//evaluate each VPL analytically, clamping the distance to avoid hot spots near clustered VPLs
+vec3 vpl_light(vec3 f_normal) {
+	vec3 ret = vec3(0);
+	for (int i = 0; i < vpl_num; i++) {
+		vec3 distance = vpl_pos[i].xyz - f_pos;
+		float distance_square = max(dot(distance, distance), 0.01);
+		ret += vpl_flux[i].rgb * max(0, dot(f_normal, distance)) * max(0, dot(vpl_normal[i].xyz, -distance)) / (distance_square * distance_square);
+	}
+	return 0.6 * min(ret, vec3(1.0));
+}
+
+//disk sampling on the 2D RSM around the fragment's projection, positions rebuilt from linear light view depth
+vec3 flat_indirect_light(vec3 f_normal) {
+	vec4 clip = rsm_matrix * vec4(f_pos, 1.0);
+	vec2 center = clip.xy / clip.w * 0.5 + 0.5;
+	float rsm_size = float(textureSize(flat_flux_map, 0).x);
+	vec2 noise = texture(noise_map, gl_FragCoord.xy / vec2(textureSize(noise_map, 0))).xy * 2.0 - 1.0;
+	vec2 rotation = vec2(noise.x * frame_rotation.x - noise.y * frame_rotation.y, noise.x * frame_rotation.y + noise.y * frame_rotation.x);
+	vec3 ret = vec3(0);
+	float weight_sum = 0.0;
+	for (int i = 0; i < sample_num; i++) {
+		vec4 tap = samples[(sample_offset + i) % MAX_SAMPLE_NUM];
+		vec2 s = tap.xy;
+		s = vec2(s.x * rotation.x - s.y * rotation.y, s.x * rotation.y + s.y * rotation.x) * flat_sample_radius;
+		vec2 uv = center + s;
+		//a texel is 1/rsm_size wide, pick the mip level from the area each sample covers
+		float footprint = 2.0 * PI * length(s) * flat_sample_radius / float(sample_num);
+		float lod = max(0.5 * log2(footprint) + log2(rsm_size) - 1.0, 0.0);
+		vec3 psai = textureLod(flat_flux_map, uv, lod).rgb;
+		vec3 geometry = textureLod(flat_geometry_map, uv, lod).xyz;
+		vec2 xy = (uv * 2.0 - 1.0) * rsm_scale * (rsm_ortho ? 1.0 : geometry.z);
+		vec3 pos = vec3(rsm_inv_view * vec4(xy, -geometry.z, 1.0));
+		vec3 normal = oct_decode(geometry.xy);
+		vec3 distance = pos - f_pos;
+		float distance_square = max(dot(distance, distance), 1e-6);
+		float weight = tap.z;
+		weight_sum += weight;
+		//texels outside the RSM or without geometry have zero flux
+		if (any(lessThan(uv, vec2(0.0))) || any(greaterThan(uv, vec2(1.0))) || geometry.z <= 0.0) continue;
+		ret += psai * weight * max(0, dot(f_normal, distance)) * max(0, dot(normal, -distance)) / (distance_square * distance_square);
+	}
+	ret /= weight_sum;
+	return 0.6 * min(ret, vec3(1.0));
+}
+
+void main() {
+	vec3 norm = normalize(f_normal);
+	o_indirect = vec4(vpl_num > 0 ? vpl_light(norm) : rsm_flat ? flat_indirect_light(norm) : indirect_light(norm), 1.0);
+	//w holds the linear view space depth, 0 means no geometry
+	o_normal_depth = vec4(norm, -(view * vec4(f_pos, 1.0)).z);
+}
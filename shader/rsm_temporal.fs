@@ -0,0 +1,61 @@
+#version 330 core
+
+out vec4 o_indirect;
+
+uniform sampler2D current_map; //indirect light of this frame
+uniform sampler2D normal_depth_map; //normal and linear depth of this frame
+uniform sampler2D history_map; //accumulated history, a holds the frame count
+uniform sampler2D prev_normal_depth_map; //normal and linear depth of the previous frame
+
+uniform mat4 inv_view;
+uniform mat4 prev_view;
+uniform mat4 prev_view_projection;
+uniform vec2 tan_half_fov;
+uniform float max_history;
+uniform bool history_valid;
+
+void main() {
+	ivec2 texel = ivec2(gl_FragCoord.xy);
+	ivec2 size = textureSize(current_map, 0);
+	vec3 current = texelFetch(current_map, texel, 0).rgb;
+	vec4 normal_depth = texelFetch(normal_depth_map, texel, 0);
+	if (normal_depth.w <= 0.0) {
+		o_indirect = vec4(current, 1.0);
+		return;
+	}
+
+	//neighbourhood mean and deviation used to clamp the history
+	vec3 m1 = vec3(0), m2 = vec3(0);
+	for (int y = -1; y <= 1; y++) {
+		for (int x = -1; x <= 1; x++) {
+			vec3 c = texelFetch(current_map, clamp(texel + ivec2(x, y), ivec2(0), size - 1), 0).rgb;
+			m1 += c;
+			m2 += c * c;
+		}
+	}
+	m1 /= 9.0;
+	vec3 sigma = sqrt(max(m2 / 9.0 - m1 * m1, vec3(0)));
+	vec3 lo = m1 - 1.5 * sigma, hi = m1 + 1.5 * sigma;
+
+	//rebuild the world position from linear depth and reproject it into the previous frame
+	vec2 uv = (vec2(texel) + 0.5) / vec2(size);
+	vec3 view_space = vec3((uv * 2.0 - 1.0) * tan_half_fov * normal_depth.w, -normal_depth.w);
+	vec4 world = inv_view * vec4(view_space, 1.0);
+	vec4 clip = prev_view_projection * world;
+	vec2 prev_uv = clip.xy / clip.w * 0.5 + 0.5;
+
+	vec3 history = current;
+	float count = 0.0;
+	if (history_valid && clip.w > 0.0 && all(greaterThanEqual(prev_uv, vec2(0))) && all(lessThanEqual(prev_uv, vec2(1)))) {
+		//a large depth or normal mismatch means the point was occluded, drop the history
+		vec4 prev = texelFetch(prev_normal_depth_map, clamp(ivec2(prev_uv * vec2(size)), ivec2(0), size - 1), 0);
+		float expected = -(prev_view * world).z;
+		if (abs(prev.w - expected) < 0.05 * expected && dot(prev.xyz, normal_depth.xyz) > 0.9) {
+			vec4 h = texture(history_map, prev_uv);
+			history = clamp(h.rgb, lo, hi);
+			count = h.a;
+		}
+	}
+	count = min(count + 1.0, max_history);
+	o_indirect = vec4(mix(history, current, 1.0 / count), count);
+}
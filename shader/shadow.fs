@@ -1,13 +1,5 @@
 #version 330 core
-in vec4 f_pos;
-
-struct Light {
-	vec3 pos;
-};
-
-uniform Light light;
-uniform float far_plane;
 
+// the shadow pass keeps the rasterized depth and never writes gl_FragDepth, so early-Z stays on
 void main() {
-    gl_FragDepth = length(f_pos.xyz - light.pos) / far_plane;
-}
\ No newline at end of file
+}
@@ -2,7 +2,8 @@
 layout (location = 0) in vec3 v_pos;
 
 uniform mat4 model;
+uniform mat4 face_matrix; // projection * view matrix of the cube face being rendered
 
 void main() {
-    gl_Position = model * vec4(v_pos, 1.0);
+    gl_Position = face_matrix * model * vec4(v_pos, 1.0);
 }
@@ -0,0 +1,56 @@
+#version 330 core
+
+struct PointLight {
+    vec3 pos;
+	float constant;
+    float linear;
+    float quadratic;
+    vec3 diffuse;
+};
+
+out vec4 o_radiance;
+
+flat in int f_layer;
+
+uniform sampler3D albedo_x; // accumulated along the x axis, stored as (y, z, x)
+uniform sampler3D albedo_y; // along the y axis, stored as (z, x, y)
+uniform sampler3D albedo_z; // along the z axis, stored as (x, y, z)
+uniform sampler3D normal_x;
+uniform sampler3D normal_y;
+uniform sampler3D normal_z;
+uniform samplerCubeShadow depth_map;
+uniform float far_plane;
+uniform float shadow_near;
+uniform vec3 voxel_min;
+uniform float voxel_cell;
+uniform PointLight light;
+
+// same cube shadow test as the shading pass, 1 means in shadow
+float calc_shadow(vec3 pos) {
+	vec3 frag_to_light = pos - light.pos;
+	vec3 a = abs(frag_to_light);
+	float d = max(a.x, max(a.y, a.z));
+	float ref = 0.5 * (far_plane + shadow_near) / (far_plane - shadow_near) + 0.5 - far_plane * shadow_near / ((far_plane - shadow_near) * d);
+	return 1.0 - texture(depth_map, vec4(frag_to_light, ref));
+}
+
+// merge the 3 axes, light the averaged albedo and normal directly and write outgoing radiance, a is occupancy
+void main() {
+	ivec3 c = ivec3(gl_FragCoord.xy, f_layer);
+	vec4 albedo = texelFetch(albedo_x, c.yzx, 0) + texelFetch(albedo_y, c.zxy, 0) + texelFetch(albedo_z, c, 0);
+	if (albedo.a == 0.0) {
+		o_radiance = vec4(0.0);
+		return;
+	}
+	vec3 normal = (texelFetch(normal_x, c.yzx, 0) + texelFetch(normal_y, c.zxy, 0) + texelFetch(normal_z, c, 0)).xyz;
+	vec3 pos = voxel_min + (vec3(c) + 0.5) * voxel_cell;
+	vec3 to_light = light.pos - pos;
+	float distance = length(to_light);
+	vec3 light_dir = to_light / distance;
+	// normals of thin two sided voxels cancel out, treat them as facing the light
+	float diff = length(normal) > 0.1 * albedo.a ? max(dot(normalize(normal), light_dir), 0.0) : 1.0;
+	float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+	// the voxel center may be half a cell behind the surface, move one cell towards the light before comparing
+	float shadow = calc_shadow(pos + light_dir * voxel_cell);
+	o_radiance = vec4(albedo.rgb / albedo.a * light.diffuse * diff * attenuation * (1.0 - shadow), 1.0);
+}
@@ -0,0 +1,32 @@
+#version 330 core
+
+struct Material {
+    sampler2D diffuse;
+    sampler2D specular;
+    float shininess;
+};
+
+// accumulate per projection axis, rgb: summed albedo or normal, a: fragment count
+layout (location = 0) out vec4 o_albedo_x;
+layout (location = 1) out vec4 o_albedo_y;
+layout (location = 2) out vec4 o_albedo_z;
+layout (location = 3) out vec4 o_normal_x;
+layout (location = 4) out vec4 o_normal_y;
+layout (location = 5) out vec4 o_normal_z;
+
+in vec3 f_normal;
+in vec2 f_coords;
+flat in int f_axis;
+
+uniform Material material;
+
+void main() {
+	vec4 albedo = vec4(vec3(texture(material.diffuse, f_coords)), 1.0);
+	vec4 normal = vec4(normalize(f_normal), 1.0);
+	o_albedo_x = f_axis == 0 ? albedo : vec4(0.0);
+	o_albedo_y = f_axis == 1 ? albedo : vec4(0.0);
+	o_albedo_z = f_axis == 2 ? albedo : vec4(0.0);
+	o_normal_x = f_axis == 0 ? normal : vec4(0.0);
+	o_normal_y = f_axis == 1 ? normal : vec4(0.0);
+	o_normal_z = f_axis == 2 ? normal : vec4(0.0);
+}
@@ -0,0 +1,78 @@
+#version 330 core
+#define LAYER_NUM 16
+layout (triangles) in;
+layout (triangle_strip, max_vertices = 48) out; // at most LAYER_NUM layers per draw
+
+in vec3 g_pos[];
+in vec3 g_normal[];
+in vec2 g_coords[];
+
+out vec3 f_normal;
+out vec2 f_coords;
+flat out int f_axis;
+
+uniform vec3 voxel_min; // minimum corner of the grid
+uniform float voxel_cell; // cell edge length
+uniform int voxel_size; // cells per grid dimension
+uniform int layer_offset; // first layer handled by this draw
+
+// swizzle grid coordinates so the projection axis becomes depth, matching the accumulation textures
+vec3 swizzle(vec3 g, int axis) {
+	if (axis == 0) return g.yzx;
+	if (axis == 1) return g.zxy;
+	return g;
+}
+
+// project along the normal's major axis to maximize the projected area,
+// push each edge out by half a pixel diagonal (conservative rasterization) and widen the layer range by half a layer
+void main() {
+	vec3 face = cross(g_pos[1] - g_pos[0], g_pos[2] - g_pos[0]);
+	vec3 a = abs(face);
+	int axis = a.x >= a.y && a.x >= a.z ? 0 : (a.y >= a.z ? 1 : 2);
+	vec3 q[3];
+	for (int i = 0; i < 3; ++i) q[i] = swizzle((g_pos[i] - voxel_min) / voxel_cell, axis);
+	vec3 plane = cross(q[1] - q[0], q[2] - q[0]);
+	if (plane.z == 0.0) return;
+	float orient = plane.z > 0.0 ? 1.0 : -1.0;
+
+	// each pushed out edge is the line dot(n, p) = c
+	vec2 n[3];
+	float c[3];
+	for (int i = 0; i < 3; ++i) {
+		vec2 e = q[(i + 1) % 3].xy - q[i].xy;
+		n[i] = normalize(vec2(e.y, -e.x) * orient);
+		c[i] = dot(n[i], q[i].xy) + 0.5 * (abs(n[i].x) + abs(n[i].y));
+	}
+	vec3 p[3];
+	float lo = 1e30, hi = -1e30;
+	for (int i = 0; i < 3; ++i) {
+		int j = (i + 2) % 3; // edge ending at vertex i
+		float det = n[j].x * n[i].y - n[j].y * n[i].x;
+		vec2 v = q[i].xy;
+		if (abs(det) > 1e-6) v = vec2(c[j] * n[i].y - c[i] * n[j].y, n[j].x * c[i] - n[i].x * c[j]) / det;
+		// sharp corners move far when pushed out, clamp them to two cells
+		vec2 d = v - q[i].xy;
+		if (length(d) > 2.0) v = q[i].xy + normalize(d) * 2.0;
+		// extrapolate depth on the triangle's plane
+		float z = q[0].z - (plane.x * (v.x - q[0].x) + plane.y * (v.y - q[0].y)) / plane.z;
+		p[i] = vec3(v, z);
+		lo = min(lo, z);
+		hi = max(hi, z);
+	}
+
+	int first = max(int(floor(lo - 0.5)), layer_offset);
+	int last = min(min(int(floor(hi + 0.5)), layer_offset + LAYER_NUM - 1), voxel_size - 1);
+	for (int layer = first; layer <= last; ++layer) {
+		for (int i = 0; i < 3; ++i) {
+			gl_Layer = layer;
+			gl_Position = vec4(p[i].xy / float(voxel_size) * 2.0 - 1.0, 0.0, 1.0);
+			gl_ClipDistance[0] = p[i].z - (float(layer) - 0.5);
+			gl_ClipDistance[1] = (float(layer) + 1.5) - p[i].z;
+			f_normal = g_normal[i];
+			f_coords = g_coords[i];
+			f_axis = axis;
+			EmitVertex();
+		}
+		EndPrimitive();
+	}
+}
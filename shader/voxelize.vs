@@ -0,0 +1,17 @@
+#version 330 core
+layout (location = 0) in vec3 v_pos;
+layout (location = 1) in vec3 v_normal;
+layout (location = 2) in vec2 v_coords;
+
+out vec3 g_pos;
+out vec3 g_normal;
+out vec2 g_coords;
+
+uniform mat4 model;
+
+// world space only, the geometry shader picks the projection axis per triangle
+void main() {
+	g_pos = vec3(model * vec4(v_pos, 1.0));
+	g_normal = transpose(inverse(mat3(model))) * v_normal;
+	g_coords = v_coords;
+}